@@ -0,0 +1,49 @@
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+
+#include <matrix.hpp>
+
+// times LU factorization of a random size x size matrix for 1, 2, 4, ... threads
+// usage: DeterminantScaling [size] [max_threads]
+int main(int argc, char** argv) {
+    const std::size_t size = argc > 1 ? std::stoul(argv[1]) : 2000;
+    const std::size_t max_threads = argc > 2 ? std::stoul(argv[2]) : mtx::ThreadPool::default_n_threads();
+
+    std::mt19937_64 gen(42);
+    std::uniform_real_distribution<double> dist(-1.0, 1.0);
+    mtx::Matrix<double> matrix(size);
+    for (std::size_t i = 0; i < size; i++) {
+        for (std::size_t j = 0; j < size; j++) {
+            matrix[i][j] = dist(gen);
+        }
+    }
+
+    const double flops = 2.0 / 3.0 * double(size) * double(size) * double(size);
+    double serial_seconds = 0;
+
+    std::cout << std::setw(8) << "threads" << std::setw(12) << "seconds"
+              << std::setw(12) << "GFLOP/s" << std::setw(10) << "speedup" << "\n";
+
+    for (std::size_t n_threads = 1; n_threads <= max_threads; n_threads *= 2) {
+        auto start = std::chrono::steady_clock::now();
+        mtx::LU<double> lu = matrix.lu(mtx::LU<double>::kDefaultBlockSize, n_threads);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        if (n_threads == 1) {
+            serial_seconds = elapsed.count();
+        }
+
+        std::cout << std::setw(8) << n_threads << std::setw(12) << std::fixed << std::setprecision(4) << elapsed.count()
+                  << std::setw(12) << std::setprecision(2) << flops / elapsed.count() * 1e-9
+                  << std::setw(10) << serial_seconds / elapsed.count() << "\n";
+
+        if (lu.is_singular()) {
+            std::cerr << "matrix is singular\n";
+        }
+    }
+}
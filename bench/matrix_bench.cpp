@@ -0,0 +1,287 @@
+#include <cstring>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <Eigen/Dense>
+#include <benchmark/benchmark.h>
+
+#include <dense_array.hpp>
+#include <fixed_matrix.hpp>
+#include <jagged_array.hpp>
+#include <matrix.hpp>
+#include <matrix_reader.hpp>
+#include <mixed_precision.hpp>
+
+// Throughput of the main operations for sizes 2..4096.
+// Every benchmark reports FLOP/s and/or bytes/s; Eigen runs the same determinant as the baseline
+// (it is what IdealDeterminant uses). Results are also written to matrix_bench.json
+// unless --benchmark_out is given, compare two runs with Google Benchmark's compare.py.
+
+namespace {
+
+constexpr std::int64_t kMinSize = 2;
+constexpr std::int64_t kMaxSize = 4096;
+
+mtx::Matrix<double> random_matrix(std::size_t size, unsigned seed = 42) {
+    std::mt19937_64 gen(seed);
+    std::uniform_real_distribution<double> dist(-1.0, 1.0);
+    mtx::Matrix<double> matrix(size, size, mtx::kUninitialized);
+    for (std::size_t i = 0; i < size; i++) {
+        for (std::size_t j = 0; j < size; j++) {
+            matrix[i][j] = dist(gen);
+        }
+    }
+    return matrix;
+}
+
+void set_flops(benchmark::State& state, double flops_per_iteration) {
+    state.counters["FLOP/s"] = benchmark::Counter(flops_per_iteration, benchmark::Counter::kIsIterationInvariantRate,
+                                                  benchmark::Counter::kIs1000);
+}
+
+void set_bytes(benchmark::State& state, double bytes_per_iteration) {
+    state.SetBytesProcessed(static_cast<std::int64_t>(bytes_per_iteration * double(state.iterations())));
+}
+
+// ------------------------------------ determinant ----------------------------------------------
+
+void BM_Determinant(benchmark::State& state) {
+    const std::size_t size = state.range(0);
+    const mtx::Matrix<double> matrix = random_matrix(size);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(matrix.determinant());
+    }
+    set_flops(state, 2.0 / 3.0 * double(size) * double(size) * double(size));
+    set_bytes(state, double(size * size * sizeof(double)));
+}
+BENCHMARK(BM_Determinant)->RangeMultiplier(2)->Range(kMinSize, kMaxSize)->Unit(benchmark::kMicrosecond);
+
+// the determinant with the factorization algorithm forced, Auto picks between the two by size
+template <mtx::LUAlgorithm Algorithm>
+void BM_LUDeterminant(benchmark::State& state) {
+    const std::size_t size = state.range(0);
+    const mtx::Matrix<double> matrix = random_matrix(size);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(matrix.lu(mtx::LU<double>::kDefaultBlockSize, 1, Algorithm).determinant());
+    }
+    set_flops(state, 2.0 / 3.0 * double(size) * double(size) * double(size));
+    set_bytes(state, double(size * size * sizeof(double)));
+}
+BENCHMARK_TEMPLATE(BM_LUDeterminant, mtx::LUAlgorithm::Blocked)
+    ->RangeMultiplier(2)->Range(kMinSize, kMaxSize)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_LUDeterminant, mtx::LUAlgorithm::Recursive)
+    ->RangeMultiplier(2)->Range(kMinSize, kMaxSize)->Unit(benchmark::kMicrosecond);
+
+// all hardware threads, the barrier-free task graph against the blocked LU with a parallel update
+template <mtx::LUAlgorithm Algorithm>
+void BM_ParallelLUDeterminant(benchmark::State& state) {
+    const std::size_t size = state.range(0);
+    const mtx::Matrix<double> matrix = random_matrix(size);
+    const std::size_t n_threads = mtx::ThreadPool::default_n_threads();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(matrix.lu(mtx::LU<double>::kDefaultBlockSize, n_threads, Algorithm).determinant());
+    }
+    set_flops(state, 2.0 / 3.0 * double(size) * double(size) * double(size));
+    set_bytes(state, double(size * size * sizeof(double)));
+}
+BENCHMARK_TEMPLATE(BM_ParallelLUDeterminant, mtx::LUAlgorithm::Blocked)
+    ->RangeMultiplier(2)->Range(kMinSize, kMaxSize)->Unit(benchmark::kMicrosecond)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_ParallelLUDeterminant, mtx::LUAlgorithm::TaskGraph)
+    ->RangeMultiplier(2)->Range(kMinSize, kMaxSize)->Unit(benchmark::kMicrosecond)->UseRealTime();
+
+// float factorization, double accumulation
+void BM_MixedDeterminant(benchmark::State& state) {
+    const std::size_t size = state.range(0);
+    const mtx::Matrix<double> matrix = random_matrix(size);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(mtx::mixed_precision_determinant(matrix));
+    }
+    set_flops(state, 2.0 / 3.0 * double(size) * double(size) * double(size));
+    set_bytes(state, double(size * size * sizeof(double)));
+}
+BENCHMARK(BM_MixedDeterminant)->RangeMultiplier(2)->Range(kMinSize, kMaxSize)->Unit(benchmark::kMicrosecond);
+
+void BM_EigenDeterminant(benchmark::State& state) {
+    const std::size_t size = state.range(0);
+    const mtx::Matrix<double> source = random_matrix(size);
+    Eigen::MatrixXd matrix(size, size);
+    for (std::size_t i = 0; i < size; i++) {
+        for (std::size_t j = 0; j < size; j++) {
+            matrix(i, j) = source[i][j];
+        }
+    }
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(matrix.determinant());
+    }
+    set_flops(state, 2.0 / 3.0 * double(size) * double(size) * double(size));
+    set_bytes(state, double(size * size * sizeof(double)));
+}
+BENCHMARK(BM_EigenDeterminant)->RangeMultiplier(2)->Range(kMinSize, kMaxSize)->Unit(benchmark::kMicrosecond);
+
+template <std::size_t Size>
+void BM_FixedDeterminant(benchmark::State& state) {
+    const mtx::FixedMatrix<double, Size, Size> matrix(random_matrix(Size));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(matrix);
+        benchmark::DoNotOptimize(matrix.determinant());
+    }
+    set_bytes(state, double(Size * Size * sizeof(double)));
+}
+BENCHMARK_TEMPLATE(BM_FixedDeterminant, 2);
+BENCHMARK_TEMPLATE(BM_FixedDeterminant, 3);
+BENCHMARK_TEMPLATE(BM_FixedDeterminant, 4);
+
+// ------------------------------------ matrix operations ----------------------------------------
+
+void BM_Gemm(benchmark::State& state) {
+    const std::size_t size = state.range(0);
+    const mtx::Matrix<double> a = random_matrix(size, 1);
+    const mtx::Matrix<double> b = random_matrix(size, 2);
+    mtx::Matrix<double> c(size, size);
+    for (auto _ : state) {
+        mtx::gemm(1.0, a, b, 0.0, c);
+        benchmark::ClobberMemory();
+    }
+    set_flops(state, 2.0 * double(size) * double(size) * double(size));
+    set_bytes(state, 3.0 * double(size * size * sizeof(double)));
+}
+BENCHMARK(BM_Gemm)->RangeMultiplier(2)->Range(kMinSize, kMaxSize)->Unit(benchmark::kMicrosecond);
+
+void BM_Transpose(benchmark::State& state) {
+    const std::size_t size = state.range(0);
+    const mtx::Matrix<double> matrix = random_matrix(size);
+    for (auto _ : state) {
+        mtx::Matrix<double> transposed = matrix.transpose();
+        benchmark::DoNotOptimize(transposed.data().data());
+    }
+    set_bytes(state, 2.0 * double(size * size * sizeof(double)));
+}
+BENCHMARK(BM_Transpose)->RangeMultiplier(2)->Range(kMinSize, kMaxSize);
+
+void BM_TransposeInplace(benchmark::State& state) {
+    const std::size_t size = state.range(0);
+    mtx::Matrix<double> matrix = random_matrix(size);
+    for (auto _ : state) {
+        matrix.transpose_inplace();
+        benchmark::ClobberMemory();
+    }
+    set_bytes(state, 2.0 * double(size * size * sizeof(double)));
+}
+BENCHMARK(BM_TransposeInplace)->RangeMultiplier(2)->Range(kMinSize, kMaxSize);
+
+// row[i] += mul * row[0] for every row, the inner step of elimination
+void BM_RowAxpy(benchmark::State& state) {
+    const std::size_t size = state.range(0);
+    mtx::DenseArray<double> array = random_matrix(size).data();
+    for (auto _ : state) {
+        for (std::size_t row = 1; row < size; row++) {
+            array.axpy_rows(row, 0, 1e-3);
+        }
+        benchmark::ClobberMemory();
+    }
+    set_flops(state, 2.0 * double(size - 1) * double(size));
+    set_bytes(state, 3.0 * double((size - 1) * size * sizeof(double)));
+}
+BENCHMARK(BM_RowAxpy)->RangeMultiplier(2)->Range(kMinSize, kMaxSize);
+
+void BM_SwapRows(benchmark::State& state) {
+    const std::size_t size = state.range(0);
+    mtx::Matrix<double> matrix = random_matrix(size);
+    for (auto _ : state) {
+        for (std::size_t row = 0; row + 1 < size; row += 2) {
+            matrix.swap_rows(row, row + 1);
+        }
+        benchmark::ClobberMemory();
+    }
+    set_bytes(state, 2.0 * double(size / 2 * 2 * size * sizeof(double)));
+}
+BENCHMARK(BM_SwapRows)->RangeMultiplier(2)->Range(kMinSize, kMaxSize);
+
+// ------------------------------------ parsing --------------------------------------------------
+
+void BM_ParseText(benchmark::State& state) {
+    const std::size_t size = state.range(0);
+    const mtx::Matrix<double> matrix = random_matrix(size);
+    std::ostringstream text_stream;
+    text_stream.precision(17);
+    text_stream << size << "\n";
+    for (std::size_t i = 0; i < size; i++) {
+        for (std::size_t j = 0; j < size; j++) {
+            text_stream << matrix[i][j] << (j + 1 < size ? ' ' : '\n');
+        }
+    }
+    const std::string text = text_stream.str();
+
+    mtx::Matrix<double> parsed(size, size, mtx::kUninitialized);
+    for (auto _ : state) {
+        std::istringstream input(text);
+        mtx::MatrixReader reader(input);
+        std::size_t parsed_size = 0;
+        reader.scan_until_next_line(parsed_size);
+        for (std::size_t i = 0; i < size; i++) {
+            reader.read_values(parsed.data().row_begin(i), size);
+        }
+        benchmark::ClobberMemory();
+    }
+    set_bytes(state, double(text.size()));
+}
+BENCHMARK(BM_ParseText)->RangeMultiplier(2)->Range(kMinSize, kMaxSize)->Unit(benchmark::kMicrosecond);
+
+// ------------------------------------ Array arithmetic -----------------------------------------
+
+// size * size elements, so the largest arrays are well past the last level cache
+void BM_ArrayExpression(benchmark::State& state) {
+    const std::size_t n_elems = state.range(0) * state.range(0);
+    const mtx::Array<double> a(n_elems, 1.0);
+    const mtx::Array<double> b(n_elems, 2.0);
+    const mtx::Array<double> c(n_elems, 3.0);
+    mtx::Array<double> res(n_elems);
+    for (auto _ : state) {
+        res = a + b * 0.5 - c;
+        benchmark::ClobberMemory();
+    }
+    set_flops(state, 3.0 * double(n_elems));
+    set_bytes(state, 4.0 * double(n_elems * sizeof(double)));
+}
+BENCHMARK(BM_ArrayExpression)->RangeMultiplier(2)->Range(kMinSize, kMaxSize);
+
+void BM_ArrayAxpy(benchmark::State& state) {
+    const std::size_t n_elems = state.range(0) * state.range(0);
+    const mtx::Array<double> src(n_elems, 1.0);
+    mtx::Array<double> dst(n_elems, 2.0);
+    for (auto _ : state) {
+        dst.axpy(1e-3, src);
+        benchmark::ClobberMemory();
+    }
+    set_flops(state, 2.0 * double(n_elems));
+    set_bytes(state, 3.0 * double(n_elems * sizeof(double)));
+}
+BENCHMARK(BM_ArrayAxpy)->RangeMultiplier(2)->Range(kMinSize, kMaxSize);
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::vector<char*> args(argv, argv + argc);
+
+    bool has_out = false;
+    for (int idx = 1; idx < argc; idx++) {
+        has_out = has_out || std::strncmp(argv[idx], "--benchmark_out=", 16) == 0;
+    }
+    std::string out_arg = "--benchmark_out=matrix_bench.json";
+    std::string format_arg = "--benchmark_out_format=json";
+    if (!has_out) {
+        args.push_back(out_arg.data());
+        args.push_back(format_arg.data());
+    }
+
+    int n_args = static_cast<int>(args.size());
+    benchmark::Initialize(&n_args, args.data());
+    if (benchmark::ReportUnrecognizedArguments(n_args, args.data())) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace mtx {
+
+// passed to container constructors that should allocate storage without writing it,
+// trivially constructible elements are left indeterminate and must be overwritten before use
+struct Uninitialized {};
+inline constexpr Uninitialized kUninitialized{};
+
+// std-compatible allocator that returns memory aligned to Alignment bytes (a SIMD register or cache line)
+template <typename T, std::size_t Alignment = 64>
+class AlignedAllocator {
+  public:
+    using value_type = T;
+    static constexpr std::size_t kAlignment = std::max(Alignment, alignof(T));
+
+    template <typename U>
+    struct rebind {
+        using other = AlignedAllocator<U, Alignment>;
+    };
+
+    AlignedAllocator() = default;
+
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment>&) {}
+
+  public:
+    T* allocate(std::size_t n) {
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(kAlignment)));
+    }
+
+    void deallocate(T* data, std::size_t) {
+        ::operator delete(data, std::align_val_t(kAlignment));
+    }
+
+    template <typename U>
+    bool operator==(const AlignedAllocator<U, Alignment>&) const { return true; }
+};
+
+// Bump allocator for scratch memory: allocation moves a pointer inside the current block,
+// deallocation is a no-op and reset() makes all memory reusable at once.
+// After a reset the blocks are merged into one, so a loop that allocates the same amount
+// on every iteration stops touching the system allocator after the first one.
+class Arena {
+  public:
+    static constexpr std::size_t kDefaultBlockSize = 1 << 20;
+    static constexpr std::size_t kBlockAlignment = 64;
+
+    explicit Arena(std::size_t block_size = kDefaultBlockSize) : block_size_(std::max<std::size_t>(block_size, 1)) {}
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    ~Arena() { release(); }
+
+  public:
+    // alignment must be a power of two not greater than kBlockAlignment
+    void* allocate(std::size_t n_bytes, std::size_t alignment = alignof(std::max_align_t)) {
+        assert(alignment != 0 && (alignment & (alignment - 1)) == 0 && alignment <= kBlockAlignment);
+
+        std::size_t offset = (used_ + alignment - 1) & ~(alignment - 1);
+        if (blocks_.empty() || offset + n_bytes > blocks_.back().size) {
+            add_block(std::max(block_size_, n_bytes));
+            offset = 0;
+        }
+
+        used_ = offset + n_bytes;
+        total_used_ += n_bytes;
+        return blocks_.back().data + offset;
+    }
+
+    // invalidates everything allocated so far
+    void reset() {
+        if (blocks_.size() > 1) {
+            std::size_t total_size = 0;
+            for (const Block& block : blocks_) {
+                total_size += block.size;
+            }
+            release();
+            add_block(total_size);
+        }
+        used_ = 0;
+        total_used_ = 0;
+    }
+
+  public: // getters
+    // bytes handed out since the last reset, without alignment gaps
+    std::size_t bytes_used() const { return total_used_; }
+
+    std::size_t n_blocks() const { return blocks_.size(); }
+
+  private:
+    struct Block {
+        std::byte* data;
+        std::size_t size;
+    };
+
+    void add_block(std::size_t size) {
+        auto* data = static_cast<std::byte*>(::operator new(size, std::align_val_t(kBlockAlignment)));
+        blocks_.push_back(Block{data, size});
+        used_ = 0;
+    }
+
+    void release() {
+        for (const Block& block : blocks_) {
+            ::operator delete(block.data, std::align_val_t(kBlockAlignment));
+        }
+        blocks_.clear();
+    }
+
+  private:
+    std::size_t block_size_ = kDefaultBlockSize;
+    std::vector<Block> blocks_{};
+    std::size_t used_ = 0;
+    std::size_t total_used_ = 0;
+};
+
+// std-compatible allocator over an Arena, containers using it must not outlive the arena
+// or its next reset(); copies of a container allocate from the same arena
+template <typename T, std::size_t Alignment = Arena::kBlockAlignment>
+class ArenaAllocator {
+  public:
+    using value_type = T;
+    static constexpr std::size_t kAlignment = std::max(Alignment, alignof(T));
+
+    template <typename U>
+    struct rebind {
+        using other = ArenaAllocator<U, Alignment>;
+    };
+
+    explicit ArenaAllocator(Arena& arena) : arena_(&arena) {}
+
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U, Alignment>& other) : arena_(other.arena()) {}
+
+  public:
+    T* allocate(std::size_t n) {
+        return static_cast<T*>(arena_->allocate(n * sizeof(T), kAlignment));
+    }
+
+    void deallocate(T*, std::size_t) {}
+
+    Arena* arena() const { return arena_; }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U, Alignment>& other) const { return arena_ == other.arena(); }
+
+  private:
+    Arena* arena_ = nullptr;
+};
+
+} // namespace mtx
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "common.hpp"
+#include "kernels.hpp"
+#include "lu.hpp"
+#include "thread_pool.hpp"
+
+namespace mtx {
+
+// how a batch of count square size x size matrices is laid out in one buffer
+enum class BatchLayout {
+    // matrix b is row-major at [b * size * size, (b + 1) * size * size)
+    Contiguous,
+    // structure of arrays: element (i, j) of matrix b is at [(i * size + j) * count + b]
+    Interleaved,
+};
+
+namespace detail {
+
+// matrices of one group are eliminated together, one SIMD-friendly lane per matrix
+template <typename T>
+inline constexpr std::size_t kBatchLanes = 64 / sizeof(T);
+
+// Gaussian elimination with partial pivoting on kBatchLanes matrices stored as [size * size][lanes],
+// the O(size^3) row updates run through the SIMD lane_axpy kernel, which vectorizes across matrices
+template <FloatingPoint T>
+void eliminate_group(std::size_t size, T* group, T* determinants) {
+    constexpr std::size_t lanes = kBatchLanes<T>;
+    auto at = [&](std::size_t row, std::size_t col) { return group + (row * size + col) * lanes; };
+
+    T sign[lanes];
+    bool singular[lanes];
+    std::fill_n(sign, lanes, T(1));
+    std::fill_n(singular, lanes, false);
+
+    for (std::size_t col = 0; col < size; ++col) {
+        T best_value[lanes];
+        std::size_t best_row[lanes];
+        for (std::size_t lane = 0; lane < lanes; ++lane) {
+            best_value[lane] = std::fabs(at(col, col)[lane]);
+            best_row[lane] = col;
+        }
+        for (std::size_t row = col + 1; row < size; ++row) {
+            const T* row_ptr = at(row, col);
+            for (std::size_t lane = 0; lane < lanes; ++lane) {
+                const T cur_val = std::fabs(row_ptr[lane]);
+                const bool better = cur_val > best_value[lane];
+                best_value[lane] = better ? cur_val : best_value[lane];
+                best_row[lane] = better ? row : best_row[lane];
+            }
+        }
+
+        for (std::size_t lane = 0; lane < lanes; ++lane) {
+            if (best_row[lane] == col) {
+                continue;
+            }
+            sign[lane] = -sign[lane];
+            for (std::size_t inner = col; inner < size; ++inner) {
+                std::swap(at(col, inner)[lane], at(best_row[lane], inner)[lane]);
+            }
+        }
+
+        T pivot[lanes];
+        const T* pivot_ptr = at(col, col);
+        for (std::size_t lane = 0; lane < lanes; ++lane) {
+            const bool is_zero = pivot_ptr[lane] == T(0);
+            singular[lane] = singular[lane] || is_zero;
+            pivot[lane] = is_zero ? T(1) : pivot_ptr[lane];
+        }
+
+        for (std::size_t row = col + 1; row < size; ++row) {
+            T neg_mul[lanes];
+            const T* row_ptr = at(row, col);
+            for (std::size_t lane = 0; lane < lanes; ++lane) {
+                neg_mul[lane] = -(row_ptr[lane] / pivot[lane]);
+            }
+            kernels::lane_axpy<lanes>(size - col - 1, neg_mul, at(col, col + 1), at(row, col + 1));
+        }
+    }
+
+    // scaled like the other determinant paths, a plain running product overflows on 16 x 16 entries of 1e30
+    ScaledProduct<T> products[lanes];
+    for (std::size_t idx = 0; idx < size; ++idx) {
+        const T* diag_ptr = at(idx, idx);
+        for (std::size_t lane = 0; lane < lanes; ++lane) {
+            products[lane].multiply(diag_ptr[lane]);
+        }
+    }
+    for (std::size_t lane = 0; lane < lanes; ++lane) {
+        determinants[lane] = singular[lane] ? T(0) : scaled_determinant(products[lane], sign[lane] < 0 ? -1 : 1);
+    }
+}
+
+template <FloatingPoint T>
+void batched_determinant_groups(std::size_t size, std::size_t count, const T* matrices, T* determinants,
+                                BatchLayout layout, std::size_t group_begin, std::size_t group_end) {
+    constexpr std::size_t lanes = kBatchLanes<T>;
+    const std::size_t n_elems = size * size;
+    std::vector<T> group(n_elems * lanes);
+    T group_determinants[lanes];
+
+    for (std::size_t group_idx = group_begin; group_idx < group_end; ++group_idx) {
+        const std::size_t first = group_idx * lanes;
+        const std::size_t n_lanes = std::min(lanes, count - first);
+
+        for (std::size_t elem = 0; elem < n_elems; ++elem) {
+            T* dst = group.data() + elem * lanes;
+            if (layout == BatchLayout::Interleaved) {
+                std::copy_n(matrices + elem * count + first, n_lanes, dst);
+            } else {
+                for (std::size_t lane = 0; lane < n_lanes; ++lane) {
+                    dst[lane] = matrices[(first + lane) * n_elems + elem];
+                }
+            }
+            // unused lanes of the last group hold identity matrices
+            std::fill(dst + n_lanes, dst + lanes, elem % (size + 1) == 0 ? T(1) : T(0));
+        }
+
+        eliminate_group(size, group.data(), group_determinants);
+        std::copy_n(group_determinants, n_lanes, determinants + first);
+    }
+}
+
+} // namespace detail
+
+// determinants of count size x size matrices, same pivoting and zero-pivot rule as Matrix::determinant()
+template <FloatingPoint T>
+void batched_determinant(std::size_t size, std::size_t count, const T* matrices, T* determinants,
+                         BatchLayout layout, ThreadPool& pool) {
+    constexpr std::size_t lanes = detail::kBatchLanes<T>;
+    const std::size_t n_groups = (count + lanes - 1) / lanes;
+    pool.parallel_for(0, n_groups, 1, [&](std::size_t group_begin, std::size_t group_end) {
+        detail::batched_determinant_groups(size, count, matrices, determinants, layout, group_begin, group_end);
+    });
+}
+
+template <FloatingPoint T>
+void batched_determinant(std::size_t size, std::size_t count, const T* matrices, T* determinants,
+                         BatchLayout layout = BatchLayout::Contiguous, std::size_t n_threads = 1) {
+    constexpr std::size_t lanes = detail::kBatchLanes<T>;
+    const std::size_t n_groups = (count + lanes - 1) / lanes;
+    if (n_threads > 1) {
+        ThreadPool pool(n_threads);
+        batched_determinant(size, count, matrices, determinants, layout, pool);
+    } else {
+        detail::batched_determinant_groups(size, count, matrices, determinants, layout, 0, n_groups);
+    }
+}
+
+} // namespace mtx
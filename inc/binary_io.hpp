@@ -0,0 +1,239 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "common.hpp"
+#include "dense_array.hpp"
+#include "matrix.hpp"
+
+namespace mtx {
+
+// ------------------------------------ binary format ------------------------------------------------
+//
+// [BinaryHeader][zero padding up to data_offset][n_rows rows of leading_dim elements]
+// Rows keep the padded in-memory layout of DenseArray and data_offset is a multiple of alignment,
+// so a mapped file can be used in place without copying or reparsing.
+
+enum class ElementType : std::uint32_t {
+    Float32 = 1,
+    Float64 = 2,
+};
+
+// long double has no ElementType, its size and layout differ between platforms
+template <FloatingPoint T>
+constexpr ElementType element_type_of() {
+    static_assert(std::is_same_v<T, float> || std::is_same_v<T, double>,
+                  "the binary format stores float and double only");
+    return std::is_same_v<T, float> ? ElementType::Float32 : ElementType::Float64;
+}
+
+struct BinaryHeader {
+    static constexpr char kMagic[8] = {'M', 'T', 'X', 'B', 'I', 'N', '\0', '\0'};
+    static constexpr std::uint32_t kVersion = 1;
+    // written in native byte order, reads back differently on a machine of the other endianness
+    static constexpr std::uint32_t kEndiannessTag = 0x01020304;
+
+    char magic[8] = {};
+    std::uint32_t version = 0;
+    ElementType element_type = ElementType::Float64;
+    std::uint32_t element_size = 0;
+    std::uint32_t endianness_tag = 0;
+    std::uint64_t n_rows = 0;
+    std::uint64_t n_cols = 0;
+    std::uint64_t leading_dim = 0;
+    std::uint64_t alignment = 0;
+    std::uint64_t data_offset = 0;
+
+    bool has_magic() const { return std::memcmp(magic, kMagic, sizeof(kMagic)) == 0; }
+};
+
+inline bool is_binary_matrix_file(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    char magic[sizeof(BinaryHeader::kMagic)] = {};
+    file.read(magic, sizeof(magic));
+    return file && std::memcmp(magic, BinaryHeader::kMagic, sizeof(magic)) == 0;
+}
+
+template <FloatingPoint T>
+bool write_binary(const Matrix<T>& matrix, const std::string& path) {
+    const DenseArray<T>& data = matrix.data();
+
+    BinaryHeader header;
+    std::memcpy(header.magic, BinaryHeader::kMagic, sizeof(header.magic));
+    header.version = BinaryHeader::kVersion;
+    header.element_type = element_type_of<T>();
+    header.element_size = sizeof(T);
+    header.endianness_tag = BinaryHeader::kEndiannessTag;
+    header.n_rows = data.n_rows();
+    header.n_cols = data.n_cols();
+    header.leading_dim = data.leading_dim();
+    header.alignment = DenseArray<T>::kAlignment;
+    header.data_offset = (sizeof(BinaryHeader) + header.alignment - 1) / header.alignment * header.alignment;
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        return false;
+    }
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    const std::string padding(header.data_offset - sizeof(header), '\0');
+    file.write(padding.data(), static_cast<std::streamsize>(padding.size()));
+    file.write(reinterpret_cast<const char*>(data.data()),
+               static_cast<std::streamsize>(data.n_rows() * data.leading_dim() * sizeof(T)));
+
+    return static_cast<bool>(file);
+}
+
+// read-only matrix backed by a memory-mapped binary file, pages are loaded on first touch
+template <FloatingPoint T>
+class MappedMatrix {
+  public:
+    MappedMatrix() = default;
+
+    MappedMatrix(const MappedMatrix&) = delete;
+    MappedMatrix& operator=(const MappedMatrix&) = delete;
+
+    MappedMatrix(MappedMatrix&& other) noexcept {
+        swap(other);
+    }
+
+    MappedMatrix& operator=(MappedMatrix&& other) noexcept {
+        if (this == &other) {
+            return *this;
+        }
+
+        MappedMatrix temp(std::move(other));
+        swap(temp);
+
+        return *this;
+    }
+
+    ~MappedMatrix() { unmap(); }
+
+  public:
+    // false if the file can not be mapped or its header does not describe a matrix of T
+    bool map(const std::string& path) {
+        unmap();
+
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+
+        struct stat file_stat {};
+        if (::fstat(fd, &file_stat) != 0 || static_cast<std::size_t>(file_stat.st_size) < sizeof(BinaryHeader)) {
+            ::close(fd);
+            return false;
+        }
+
+        const std::size_t mapping_size = static_cast<std::size_t>(file_stat.st_size);
+        void* mapping = ::mmap(nullptr, mapping_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (mapping == MAP_FAILED) {
+            return false;
+        }
+
+        mapping_ = mapping;
+        mapping_size_ = mapping_size;
+        std::memcpy(&header_, mapping_, sizeof(header_));
+
+        if (!header_is_valid()) {
+            unmap();
+            return false;
+        }
+
+        data_ = reinterpret_cast<const T*>(static_cast<const char*>(mapping_) + header_.data_offset);
+        ::madvise(mapping_, mapping_size_, MADV_SEQUENTIAL);
+        return true;
+    }
+
+  public: // getters
+    bool empty() const { return n_rows() == 0 || n_cols() == 0; }
+
+    std::size_t n_rows() const { return header_.n_rows; }
+    std::size_t n_cols() const { return header_.n_cols; }
+    std::size_t leading_dim() const { return header_.leading_dim; }
+
+    const T* data() const { return data_; }
+    const T* row_begin(std::size_t idx) const { return data_ + idx * leading_dim(); }
+
+    RowView<const T> operator[](std::size_t idx) const {
+        return RowView<const T>(row_begin(idx), n_cols());
+    }
+
+  public:
+    Matrix<T> to_matrix() const {
+        Matrix<T> matrix(n_rows(), n_cols(), kUninitialized);
+        for (std::size_t row = 0; row < n_rows(); ++row) {
+            std::copy_n(row_begin(row), n_cols(), matrix.data().row_begin(row));
+        }
+        return matrix;
+    }
+
+  private:
+    bool header_is_valid() const {
+        if (!header_.has_magic() || header_.version != BinaryHeader::kVersion) {
+            return false;
+        }
+        if (header_.endianness_tag != BinaryHeader::kEndiannessTag) {
+            return false;
+        }
+        if (header_.element_type != element_type_of<T>() || header_.element_size != sizeof(T)) {
+            return false;
+        }
+        if (header_.leading_dim < header_.n_cols || header_.alignment == 0 ||
+            header_.data_offset % alignof(T) != 0 || header_.data_offset < sizeof(BinaryHeader)) {
+            return false;
+        }
+
+        // a crafted header must not wrap the size around: every factor is checked by division first
+        if (header_.data_offset > mapping_size_) {
+            return false;
+        }
+        const std::uint64_t available = (mapping_size_ - header_.data_offset) / sizeof(T);
+        // rows of zero elements take no space, any n_rows would fit
+        if (header_.leading_dim == 0) {
+            return header_.n_rows == 0;
+        }
+        if (header_.n_rows > available / header_.leading_dim) {
+            return false;
+        }
+        return header_.n_rows * header_.leading_dim <= available;
+    }
+
+    void unmap() {
+        if (mapping_ != nullptr) {
+            ::munmap(mapping_, mapping_size_);
+        }
+        mapping_ = nullptr;
+        mapping_size_ = 0;
+        data_ = nullptr;
+        header_ = BinaryHeader{};
+    }
+
+    void swap(MappedMatrix& other) noexcept {
+        std::swap(mapping_, other.mapping_);
+        std::swap(mapping_size_, other.mapping_size_);
+        std::swap(header_, other.header_);
+        std::swap(data_, other.data_);
+    }
+
+  private:
+    void* mapping_ = nullptr;
+    std::size_t mapping_size_ = 0;
+    BinaryHeader header_{};
+    const T* data_ = nullptr;
+};
+
+} // namespace mtx
@@ -1,11 +1,33 @@
 #pragma once
 
+#include <algorithm>
 #include <cmath>
+#include <concepts>
+#include <istream>
 #include <limits>
+#include <sstream>
+#include <string>
 
 template<typename T>
 concept FloatingPoint = std::floating_point<T>;
 
+// element types of Matrix: floating point, integers and user-defined rings (big integers, rationals...);
+// only floating point matrices are factored with LU, the others get exact elimination
+template<typename T>
+concept Ring = std::regular<T> && requires(const T a, const T b) {
+    T(0);
+    T(1);
+    { a + b } -> std::convertible_to<T>;
+    { a - b } -> std::convertible_to<T>;
+    { a * b } -> std::convertible_to<T>;
+    { -a } -> std::convertible_to<T>;
+} && requires(T a, const T b) {
+    // the GEMM and row kernels accumulate in place
+    a += b;
+    a -= b;
+    a *= b;
+};
+
 // ------------------------------------ Floating point comparsion ------------------------------------
 
 template<FloatingPoint T>
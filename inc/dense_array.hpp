@@ -0,0 +1,354 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "allocators.hpp"
+#include "jagged_array.hpp"
+#include "kernels.hpp"
+#include "stats.hpp"
+
+namespace mtx {
+
+// non-owning view of one row of a dense array, T may be const-qualified
+template <typename T>
+class RowView {
+  public:
+    RowView() = default;
+
+    RowView(T* data, std::size_t size) : size_(size), data_(data) {}
+
+    operator RowView<const T>() const requires (!std::is_const_v<T>) { return RowView<const T>(data_, size_); }
+
+  public:
+    T& operator[](std::size_t idx) const { return data_[idx]; }
+
+    T* begin() const { return data_; }
+    T* end() const { return data_ + size_; }
+
+  public:
+    std::size_t size() const { return size_; }
+
+    bool empty() const { return size() == 0; }
+
+  public:
+    const RowView& operator+=(RowView<const std::remove_const_t<T>> other) const {
+        assert(other.size() == size());
+        kernels::add(size(), other.begin(), begin());
+        return *this;
+    }
+
+    const RowView& operator-=(RowView<const std::remove_const_t<T>> other) const {
+        assert(other.size() == size());
+        kernels::sub(size(), other.begin(), begin());
+        return *this;
+    }
+
+    const RowView& operator*=(const std::remove_const_t<T>& scalar) const {
+        kernels::scale(size(), scalar, begin());
+        return *this;
+    }
+
+    // this[i] += mul * src[i] for i in [first, last), without temporaries
+    const RowView& axpy(const std::remove_const_t<T>& mul, RowView<const std::remove_const_t<T>> src,
+                        std::size_t first, std::size_t last) const {
+        assert(first <= last && last <= size() && last <= src.size());
+        kernels::axpy(last - first, mul, src.begin() + first, begin() + first);
+        return *this;
+    }
+
+    const RowView& axpy(const std::remove_const_t<T>& mul, RowView<const std::remove_const_t<T>> src) const {
+        return axpy(mul, src, 0, size());
+    }
+
+    void fill(const std::remove_const_t<T>& value) const {
+        std::fill(begin(), end(), value);
+    }
+
+  private:
+    std::size_t size_ = 0;
+    T* data_ = nullptr;
+};
+
+template <typename T>
+inline std::ostream& operator<<(std::ostream& ostream, RowView<T> row) {
+    if (row.empty()) {
+        return ostream;
+    }
+    std::copy(row.begin(), row.end() - 1, std::ostream_iterator<std::remove_const_t<T>>(ostream, ", "));
+    ostream << *(row.end() - 1);
+    return ostream;
+}
+
+// strong type for an explicit distance (in elements) between starts of neighbouring rows
+struct LeadingDim {
+    std::size_t value;
+};
+
+// rectangular array stored row-major in a single aligned buffer,
+// rows are padded up to leading_dim() elements so every row starts on an aligned address
+// (as long as Alloc returns memory aligned to kAlignment, as the default one does);
+// the buffer may hold more rows than n_rows(), see row_capacity()
+template <typename T, typename Alloc = AlignedAllocator<T>>
+class DenseArray {
+  public:
+    using allocator_type = Alloc;
+    static constexpr std::size_t kAlignment = 64;
+
+    DenseArray() = default;
+
+    explicit DenseArray(const Alloc& alloc) : alloc_(alloc) {}
+
+    DenseArray(std::initializer_list<std::initializer_list<T>> init_lists, const Alloc& alloc = Alloc())
+        : DenseArray(init_lists.size(), init_lists.size() == 0 ? 0 : init_lists.begin()->size(), T{}, alloc)
+    {
+        std::size_t row_idx = 0;
+        for (const auto& row_list : init_lists) {
+            assert(row_list.size() == n_cols());
+            std::copy(row_list.begin(), row_list.end(), row_begin(row_idx));
+            ++row_idx;
+        }
+    }
+
+    DenseArray(std::size_t n_rows, std::size_t n_cols, const T& elem = T{}, const Alloc& alloc = Alloc())
+        : DenseArray(n_rows, n_cols, LeadingDim{padded_leading_dim(n_cols)}, elem, alloc) {}
+
+    DenseArray(std::size_t n_rows, std::size_t n_cols, LeadingDim leading_dim, const T& elem = T{},
+               const Alloc& alloc = Alloc())
+        : alloc_(alloc), n_rows_(n_rows), row_capacity_(n_rows), n_cols_(n_cols), leading_dim_(leading_dim.value),
+          data_(allocate(buffer_size()))
+    {
+        assert(leading_dim_ >= n_cols_);
+        std::uninitialized_fill_n(data_, buffer_size(), elem);
+    }
+
+    // only the row padding is written, the n_rows x n_cols elements must be overwritten before use
+    DenseArray(std::size_t n_rows, std::size_t n_cols, Uninitialized, const Alloc& alloc = Alloc())
+        : alloc_(alloc), n_rows_(n_rows), row_capacity_(n_rows), n_cols_(n_cols), leading_dim_(padded_leading_dim(n_cols)),
+          data_(allocate(buffer_size()))
+    {
+        for (std::size_t row_idx = 0; row_idx < n_rows_; ++row_idx) {
+            std::uninitialized_default_construct_n(row_begin(row_idx), n_cols_);
+            std::uninitialized_value_construct(row_begin(row_idx) + n_cols_, row_begin(row_idx) + leading_dim_);
+        }
+    }
+
+    template<typename Iter>
+    requires IteratorOf<Iter, T>
+    DenseArray(std::size_t n_rows, std::size_t n_cols, Iter elems_begin, Iter elems_end, const Alloc& alloc = Alloc())
+        : DenseArray(n_rows, n_cols, T{}, alloc)
+    {
+        auto elem_it = elems_begin;
+        for (std::size_t row_idx = 0; row_idx < n_rows_ && elem_it != elems_end; ++row_idx) {
+            for (std::size_t col_idx = 0; col_idx < n_cols_ && elem_it != elems_end; ++col_idx, ++elem_it) {
+                (*this)[row_idx][col_idx] = *elem_it;
+            }
+        }
+    }
+
+  public:
+    DenseArray(const DenseArray& other)
+        : alloc_(std::allocator_traits<Alloc>::select_on_container_copy_construction(other.alloc_)),
+          n_rows_(other.n_rows_), row_capacity_(other.n_rows_), n_cols_(other.n_cols_), leading_dim_(other.leading_dim_),
+          data_(allocate(buffer_size()))
+    {
+        std::uninitialized_copy_n(other.data_, buffer_size(), data_);
+    }
+
+    DenseArray(DenseArray&& other) noexcept : alloc_(other.alloc_) {
+        swap(other);
+    }
+
+    DenseArray& operator=(const DenseArray& other) {
+        if (this == &other) {
+            return *this;
+        }
+
+        DenseArray temp(other);
+        swap(temp);
+
+        return *this;
+    }
+
+    DenseArray& operator=(DenseArray&& other) noexcept {
+        if (this == &other) {
+            return *this;
+        }
+
+        swap(other);
+
+        return *this;
+    }
+
+    ~DenseArray() { deallocate(data_, buffer_size(), capacity_size()); }
+
+  public:
+    RowView<T> operator[](std::size_t idx) {
+        assert(idx < n_rows_);
+        return RowView<T>(row_begin(idx), n_cols_);
+    }
+
+    RowView<const T> operator[](std::size_t idx) const {
+        assert(idx < n_rows_);
+        return RowView<const T>(row_begin(idx), n_cols_);
+    }
+
+    T* data() { return data_; }
+    const T* data() const { return data_; }
+
+    T* row_begin(std::size_t idx) { return data_ + idx * leading_dim_; }
+    const T* row_begin(std::size_t idx) const { return data_ + idx * leading_dim_; }
+
+  public:
+    bool empty() const { return n_rows_ == 0 || n_cols_ == 0; }
+
+    std::size_t n_rows() const { return n_rows_; }
+    std::size_t n_cols() const { return n_cols_; }
+    std::size_t leading_dim() const { return leading_dim_; }
+    std::size_t row_capacity() const { return row_capacity_; }
+
+    Alloc get_allocator() const { return alloc_; }
+
+    static std::size_t padded_leading_dim(std::size_t n_cols) {
+        if (kAlignment % sizeof(T) != 0) {
+            return n_cols;
+        }
+        constexpr std::size_t elems_per_line = kAlignment / sizeof(T);
+        return (n_cols + elems_per_line - 1) / elems_per_line * elems_per_line;
+    }
+
+  public:
+    void swap_rows(std::size_t first_idx, std::size_t second_idx) {
+        if (first_idx == second_idx) {
+            return;
+        }
+        std::swap_ranges(row_begin(first_idx), row_begin(first_idx) + n_cols_, row_begin(second_idx));
+    }
+
+    // row[dst] += mul * row[src] on columns [first_col, n_cols())
+    void axpy_rows(std::size_t dst_idx, std::size_t src_idx, const T& mul, std::size_t first_col = 0) {
+        (*this)[dst_idx].axpy(mul, (*this)[src_idx], first_col, n_cols_);
+    }
+
+    void fill(const T& value) {
+        std::fill_n(data_, buffer_size(), value);
+    }
+
+    // keeps the overlapping top-left block, new elements are set to value.
+    // With n_cols() unchanged, growing past row_capacity() at least doubles it, so appending rows one
+    // at a time is amortized O(1) per row; shrinking keeps the storage, see shrink_to_fit()
+    void resize(std::size_t new_n_rows, std::size_t new_n_cols, const T& value = T{}) {
+        if (new_n_cols == n_cols_) {
+            resize_rows(new_n_rows, value);
+            return;
+        }
+
+        DenseArray temp(new_n_rows, new_n_cols, value, alloc_);
+        std::size_t rows_to_copy = std::min(n_rows_, new_n_rows);
+        std::size_t cols_to_copy = std::min(n_cols_, new_n_cols);
+        for (std::size_t row_idx = 0; row_idx < rows_to_copy; ++row_idx) {
+            std::copy_n(row_begin(row_idx), cols_to_copy, temp.row_begin(row_idx));
+        }
+
+        swap(temp);
+    }
+
+    void reserve_rows(std::size_t new_row_capacity) {
+        if (new_row_capacity > row_capacity_) {
+            replace_buffer(allocate(new_row_capacity * leading_dim_), new_row_capacity);
+        }
+    }
+
+    void shrink_to_fit() {
+        if (row_capacity_ > n_rows_) {
+            replace_buffer(allocate(buffer_size()), n_rows_);
+        }
+    }
+
+  private:
+    void resize_rows(std::size_t new_n_rows, const T& value) {
+        if (new_n_rows <= n_rows_) {
+            std::destroy(row_begin(new_n_rows), row_begin(n_rows_));
+            n_rows_ = new_n_rows;
+            return;
+        }
+
+        if (new_n_rows > row_capacity_) {
+            // new rows are built before the old ones move, value may refer to one of them
+            const std::size_t new_row_capacity = std::max(new_n_rows, 2 * row_capacity_);
+            T* new_buffer = allocate(new_row_capacity * leading_dim_);
+            std::uninitialized_fill(new_buffer + buffer_size(), new_buffer + new_n_rows * leading_dim_, value);
+            replace_buffer(new_buffer, new_row_capacity);
+        } else {
+            std::uninitialized_fill(row_begin(n_rows_), row_begin(new_n_rows), value);
+        }
+        n_rows_ = new_n_rows;
+    }
+
+    // moves the n_rows() rows into new_buffer of new_row_capacity rows
+    void replace_buffer(T* new_buffer, std::size_t new_row_capacity) {
+        std::uninitialized_move_n(data_, buffer_size(), new_buffer);
+        deallocate(data_, buffer_size(), capacity_size());
+        data_ = new_buffer;
+        row_capacity_ = new_row_capacity;
+    }
+
+    // buffers always travel together with the allocator that owns them
+    void swap(DenseArray& other) noexcept {
+        std::swap(alloc_, other.alloc_);
+        std::swap(n_rows_, other.n_rows_);
+        std::swap(row_capacity_, other.row_capacity_);
+        std::swap(n_cols_, other.n_cols_);
+        std::swap(leading_dim_, other.leading_dim_);
+        std::swap(data_, other.data_);
+    }
+
+    // elements of the n_rows() rows, the only constructed ones
+    std::size_t buffer_size() const { return n_rows_ * leading_dim_; }
+    std::size_t capacity_size() const { return row_capacity_ * leading_dim_; }
+
+    T* allocate(std::size_t capacity) {
+        if (capacity == 0) {
+            return nullptr;
+        }
+        stats::add(stats::Counter::Allocations);
+        stats::add(stats::Counter::AllocatedBytes, capacity * sizeof(T));
+        return std::allocator_traits<Alloc>::allocate(alloc_, capacity);
+    }
+
+    void deallocate(T* data, std::size_t size, std::size_t capacity) {
+        if (data == nullptr) {
+            return;
+        }
+        std::destroy_n(data, size);
+        std::allocator_traits<Alloc>::deallocate(alloc_, data, capacity);
+    }
+
+  private:
+    [[no_unique_address]] Alloc alloc_{};
+    std::size_t n_rows_ = 0;
+    std::size_t row_capacity_ = 0;
+    std::size_t n_cols_ = 0;
+    std::size_t leading_dim_ = 0;
+    T* data_ = nullptr;
+};
+
+template <typename T, typename Alloc>
+inline std::ostream& operator<<(std::ostream& ostream, const DenseArray<T, Alloc>& array) {
+    for (std::size_t row_idx = 0; row_idx < array.n_rows(); ++row_idx) {
+        if (row_idx != 0) {
+            ostream << "\n";
+        }
+        ostream << array[row_idx];
+    }
+    return ostream;
+}
+
+} // namespace mtx
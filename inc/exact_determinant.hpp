@@ -0,0 +1,328 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include "common.hpp"
+#include "dense_array.hpp"
+#include "matrix_view.hpp"
+#include "stats.hpp"
+#include "thread_pool.hpp"
+
+// Exact determinants of integer and other non-floating matrices: fraction-free Bareiss elimination
+// for any ring with exact division, and a multi-modular path for integer matrices that eliminates
+// modulo word-sized primes and rebuilds the result with the Chinese remainder theorem.
+
+namespace mtx {
+
+namespace detail {
+
+// products of two entries are formed in a wider type before the exact division
+template <typename T>
+struct BareissWide {
+    using type = T;
+};
+
+template <std::signed_integral T>
+requires (sizeof(T) <= 4)
+struct BareissWide<T> {
+    using type = std::int64_t;
+};
+
+template <std::signed_integral T>
+requires (sizeof(T) == 8)
+struct BareissWide<T> {
+    __extension__ using type = __int128;
+};
+
+} // namespace detail
+
+// Fraction-free Gaussian elimination: after step k every entry is a (k + 1) x (k + 1) minor and the
+// division by the previous pivot is exact, so no fractions and no rounding appear. Integer matrices
+// get their exact determinant whenever it fits into T; user-defined rings with exact division
+// (big integers, polynomials over a field...) work as they are.
+template <Ring T, typename Alloc>
+requires (!std::unsigned_integral<T>) && requires(const T a, const T b) { { a / b } -> std::convertible_to<T>; }
+T bareiss_determinant(DenseArray<T, Alloc> matrix) {
+    assert(matrix.n_rows() == matrix.n_cols());
+    using Wide = typename detail::BareissWide<T>::type;
+
+    const std::size_t n = matrix.n_rows();
+    if (n == 0) {
+        return T(1);
+    }
+
+    T sign = T(1);
+    T prev_pivot = T(1);
+    for (std::size_t k = 0; k < n; ++k) {
+        stats::add(stats::Counter::PivotSearches);
+        if (matrix.row_begin(k)[k] == T(0)) {
+            std::size_t row = k + 1;
+            while (row < n && matrix.row_begin(row)[k] == T(0)) {
+                ++row;
+            }
+            if (row == n) {
+                return T(0);
+            }
+            matrix.swap_rows(row, k);
+            sign = -sign;
+            stats::add(stats::Counter::RowSwaps);
+        }
+
+        const T* pivot_row = matrix.row_begin(k);
+        const Wide pivot = Wide(pivot_row[k]);
+        const Wide divisor = Wide(prev_pivot);
+        for (std::size_t row = k + 1; row < n; ++row) {
+            T* row_ptr = matrix.row_begin(row);
+            const Wide mul = Wide(row_ptr[k]);
+            for (std::size_t col = k + 1; col < n; ++col) {
+                row_ptr[col] = static_cast<T>((Wide(row_ptr[col]) * pivot - mul * Wide(pivot_row[col])) / divisor);
+            }
+        }
+        prev_pivot = pivot_row[k];
+    }
+
+    return sign * matrix.row_begin(n - 1)[n - 1];
+}
+
+// ------------------------------------ multi-modular determinant ------------------------------------
+
+namespace detail {
+
+// arithmetic modulo a prime p < 2^31: x mod p for x < 2^63 goes through a floating point reciprocal,
+// the estimated quotient is off by at most one, which is cheaper than a 64-bit division
+class Modulus {
+  public:
+    explicit Modulus(std::uint64_t p) : p_(p), reciprocal_(1.0 / double(p)) {}
+
+    std::uint64_t value() const { return p_; }
+
+    std::uint64_t reduce(std::uint64_t x) const {
+        const auto quotient = static_cast<std::uint64_t>(double(x) * reciprocal_);
+        auto rest = static_cast<std::int64_t>(x - quotient * p_);
+        if (rest < 0) {
+            rest += static_cast<std::int64_t>(p_);
+        } else if (rest >= static_cast<std::int64_t>(p_)) {
+            rest -= static_cast<std::int64_t>(p_);
+        }
+        return static_cast<std::uint64_t>(rest);
+    }
+
+    std::uint64_t mul(std::uint64_t a, std::uint64_t b) const { return reduce(a * b); }
+
+    std::uint64_t pow(std::uint64_t base, std::uint64_t exponent) const {
+        std::uint64_t res = 1;
+        for (; exponent > 0; exponent >>= 1) {
+            if (exponent & 1) {
+                res = mul(res, base);
+            }
+            base = mul(base, base);
+        }
+        return res;
+    }
+
+    // p is prime, so a^(p - 2) is the inverse of a != 0
+    std::uint64_t inverse(std::uint64_t a) const { return pow(a, p_ - 2); }
+
+    // a residue of any integer value, negative ones included; reduced in 64 bits, p does not fit
+    // into types narrower than 32 bits
+    template <std::integral T>
+    std::uint64_t from(T value) const {
+        if constexpr (std::is_signed_v<T>) {
+            const std::int64_t rest = static_cast<std::int64_t>(value) % static_cast<std::int64_t>(p_);
+            return static_cast<std::uint64_t>(rest < 0 ? rest + static_cast<std::int64_t>(p_) : rest);
+        } else {
+            return static_cast<std::uint64_t>(value) % p_;
+        }
+    }
+
+  private:
+    std::uint64_t p_;
+    double reciprocal_;
+};
+
+// deterministic Miller-Rabin, the bases 2, 7 and 61 are enough below 2^32
+inline bool is_prime(std::uint64_t n) {
+    if (n < 2) {
+        return false;
+    }
+    for (std::uint64_t small : {2, 3, 5, 7, 11, 13, 61}) {
+        if (n % small == 0) {
+            return n == small;
+        }
+    }
+
+    std::uint64_t odd = n - 1;
+    int twos = 0;
+    for (; odd % 2 == 0; odd /= 2) {
+        ++twos;
+    }
+    for (std::uint64_t base : {2, 7, 61}) {
+        std::uint64_t x = 1;
+        for (std::uint64_t power = base, exponent = odd; exponent > 0; exponent >>= 1, power = power * power % n) {
+            if (exponent & 1) {
+                x = x * power % n;
+            }
+        }
+        if (x == 1 || x == n - 1) {
+            continue;
+        }
+        bool composite = true;
+        for (int idx = 1; idx < twos && composite; ++idx) {
+            x = x * x % n;
+            composite = x != n - 1;
+        }
+        if (composite) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// the largest count primes below 2^31, each carries almost 31 bits of the result
+inline std::vector<std::uint64_t> modular_primes(std::size_t count) {
+    std::vector<std::uint64_t> primes;
+    primes.reserve(count);
+    for (std::uint64_t candidate = (std::uint64_t(1) << 31) - 1; primes.size() < count; candidate -= 2) {
+        if (is_prime(candidate)) {
+            primes.push_back(candidate);
+        }
+    }
+    return primes;
+}
+
+// det mod p by Gaussian elimination over the field Z/p, scratch holds n * n residues
+template <typename TV>
+std::uint64_t determinant_mod(MatrixView<TV> view, const Modulus& mod, std::vector<std::uint64_t>& scratch) {
+    const std::size_t n = view.n_rows();
+    const std::uint64_t p = mod.value();
+    scratch.resize(n * n);
+    for (std::size_t row = 0; row < n; ++row) {
+        for (std::size_t col = 0; col < n; ++col) {
+            scratch[row * n + col] = mod.from(view(row, col));
+        }
+    }
+    auto row_ptr = [&](std::size_t row) { return scratch.data() + row * n; };
+
+    std::uint64_t det = 1;
+    for (std::size_t k = 0; k < n; ++k) {
+        std::size_t pivot = k;
+        while (pivot < n && row_ptr(pivot)[k] == 0) {
+            ++pivot;
+        }
+        if (pivot == n) {
+            return 0;
+        }
+        if (pivot != k) {
+            std::swap_ranges(row_ptr(k) + k, row_ptr(k) + n, row_ptr(pivot) + k);
+            det = p - det;
+        }
+
+        const std::uint64_t* pivot_row = row_ptr(k);
+        det = mod.mul(det, pivot_row[k]);
+        const std::uint64_t inverse = mod.inverse(pivot_row[k]);
+        for (std::size_t row = k + 1; row < n; ++row) {
+            std::uint64_t* current = row_ptr(row);
+            const std::uint64_t mul = mod.mul(current[k], inverse);
+            if (mul == 0) {
+                continue;
+            }
+            // both terms are below 2^31, the sum stays below 2^63
+            for (std::size_t col = k + 1; col < n; ++col) {
+                current[col] = mod.reduce(current[col] + (p - pivot_row[col]) * mul);
+            }
+        }
+    }
+    return det;
+}
+
+// log2 of the Hadamard bound prod_i ||row_i||, |det| never exceeds it
+template <typename TV>
+double hadamard_bits(MatrixView<TV> view) {
+    double bits = 0;
+    for (std::size_t row = 0; row < view.n_rows(); ++row) {
+        double norm2 = 0;
+        for (std::size_t col = 0; col < view.n_cols(); ++col) {
+            const double value = static_cast<double>(view(row, col));
+            norm2 += value * value;
+        }
+        if (norm2 == 0) {
+            return -std::numeric_limits<double>::infinity();
+        }
+        bits += 0.5 * std::log2(norm2);
+    }
+    return bits;
+}
+
+} // namespace detail
+
+// Exact determinant of an integer matrix without big-integer elimination: det mod p is computed for
+// enough 31-bit primes to cover the Hadamard bound (the primes run in parallel on n_threads), then the
+// residues are combined by Garner's algorithm with balanced digits, so only the final O(k^2)
+// reconstruction uses R. R is the result type, e.g. a big integer; for a built-in R the determinant
+// must fit into it, as with any integer arithmetic, and only the primes needed for R's range are used.
+template <typename R, typename TV>
+requires std::integral<std::remove_const_t<TV>> && Ring<R> && std::constructible_from<R, std::int64_t>
+R modular_determinant(MatrixView<TV> view, const std::size_t n_threads = 1) {
+    assert(view.n_rows() == view.n_cols());
+    if (view.n_rows() == 0) {
+        return R(1);
+    }
+
+    double needed_bits = detail::hadamard_bits(view);
+    if (needed_bits == -std::numeric_limits<double>::infinity()) {
+        return R(0);
+    }
+    if constexpr (std::numeric_limits<R>::is_specialized) {
+        needed_bits = std::min(needed_bits, double(std::numeric_limits<R>::digits));
+    }
+    // one bit for the sign, one for rounding of the bound
+    const auto n_primes = static_cast<std::size_t>(std::ceil((needed_bits + 2) / 30.0));
+    const std::vector<std::uint64_t> primes = detail::modular_primes(std::max<std::size_t>(n_primes, 1));
+
+    std::vector<std::uint64_t> residues(primes.size());
+    auto run = [&](std::size_t begin, std::size_t end) {
+        std::vector<std::uint64_t> scratch;
+        for (std::size_t idx = begin; idx < end; ++idx) {
+            residues[idx] = detail::determinant_mod(view, detail::Modulus(primes[idx]), scratch);
+        }
+    };
+    if (n_threads > 1 && primes.size() > 1) {
+        ThreadPool pool(std::min(n_threads, primes.size()));
+        pool.parallel_for(0, primes.size(), 1, run);
+    } else {
+        run(0, primes.size());
+    }
+
+    // det = d_0 + p_0 * (d_1 + p_1 * (d_2 + ...)) with |d_i| <= p_i / 2
+    std::vector<std::int64_t> digits(primes.size());
+    for (std::size_t idx = 0; idx < primes.size(); ++idx) {
+        const detail::Modulus mod(primes[idx]);
+        const auto p = static_cast<std::int64_t>(primes[idx]);
+
+        std::uint64_t prefix = 0;
+        std::uint64_t radix = 1;
+        for (std::size_t prev = 0; prev < idx; ++prev) {
+            const std::int64_t digit = digits[prev] % p;
+            prefix = mod.reduce(prefix + mod.mul(static_cast<std::uint64_t>(digit < 0 ? digit + p : digit), radix));
+            radix = mod.mul(radix, primes[prev]);
+        }
+        const std::uint64_t digit = mod.mul(mod.reduce(residues[idx] + primes[idx] - prefix), mod.inverse(radix));
+        digits[idx] = digit > primes[idx] / 2 ? static_cast<std::int64_t>(digit) - p : static_cast<std::int64_t>(digit);
+    }
+
+    R res = R(digits.back());
+    for (std::size_t idx = digits.size() - 1; idx-- > 0;) {
+        res = res * R(static_cast<std::int64_t>(primes[idx])) + R(digits[idx]);
+    }
+    return res;
+}
+
+} // namespace mtx
@@ -0,0 +1,173 @@
+#pragma once
+
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <functional>
+#include <type_traits>
+
+// Lazy element-wise arithmetic: a + b * s - c builds a small tree of expression nodes that
+// only reference their operands, the whole tree is evaluated in a single loop when it is
+// assigned to an Array or a Matrix, without intermediate buffers.
+
+// every element of the destination depends only on the same element of the operands,
+// so the loop may be vectorized even when the destination is also an operand
+#if defined(__clang__)
+#define MTX_ELEMENTWISE_LOOP _Pragma("clang loop vectorize(assume_safety)")
+#elif defined(__GNUC__)
+#define MTX_ELEMENTWISE_LOOP _Pragma("GCC ivdep")
+#else
+#define MTX_ELEMENTWISE_LOOP
+#endif
+
+namespace mtx {
+
+enum class ExprShape {
+    Array,
+    Matrix,
+};
+
+// Specialized by every type that can be an operand. Array-shaped operands provide
+// size(e) and at(e, idx), matrix-shaped ones n_rows(e), n_cols(e) and at(e, row, col).
+template <typename E>
+struct ExprTraits;
+
+template <typename E>
+concept Expression = requires { ExprTraits<E>::kShape; };
+
+template <typename E, ExprShape shape>
+concept ExpressionOf = Expression<E> && ExprTraits<E>::kShape == shape;
+
+template <Expression E>
+using expr_value_t = typename ExprTraits<E>::value_type;
+
+// base of expression nodes, nodes are stored by value inside their parents and
+// containers by reference, so a full expression stays valid until the end of the statement
+struct ExprNode {};
+
+// cheap non-owning operands (views) may be stored by value as well
+template <typename E>
+inline constexpr bool kExprByValue = std::derived_from<E, ExprNode>;
+
+template <typename E>
+using expr_storage_t = std::conditional_t<kExprByValue<E>, E, const E&>;
+
+template <typename Op, Expression L, Expression R>
+class BinaryExpr : public ExprNode {
+  public:
+    using value_type = expr_value_t<L>;
+    static constexpr ExprShape kShape = ExprTraits<L>::kShape;
+
+    BinaryExpr(const L& left, const R& right) : left_(left), right_(right) {}
+
+  public:
+    std::size_t size() const { return ExprTraits<L>::size(left_); }
+    std::size_t n_rows() const { return ExprTraits<L>::n_rows(left_); }
+    std::size_t n_cols() const { return ExprTraits<L>::n_cols(left_); }
+
+    value_type at(std::size_t idx) const {
+        return Op{}(ExprTraits<L>::at(left_, idx), ExprTraits<R>::at(right_, idx));
+    }
+
+    value_type at(std::size_t row, std::size_t col) const {
+        return Op{}(ExprTraits<L>::at(left_, row, col), ExprTraits<R>::at(right_, row, col));
+    }
+
+  private:
+    expr_storage_t<L> left_;
+    expr_storage_t<R> right_;
+};
+
+template <Expression E>
+class ScaleExpr : public ExprNode {
+  public:
+    using value_type = expr_value_t<E>;
+    static constexpr ExprShape kShape = ExprTraits<E>::kShape;
+
+    ScaleExpr(const E& expr, const value_type& scalar) : expr_(expr), scalar_(scalar) {}
+
+  public:
+    std::size_t size() const { return ExprTraits<E>::size(expr_); }
+    std::size_t n_rows() const { return ExprTraits<E>::n_rows(expr_); }
+    std::size_t n_cols() const { return ExprTraits<E>::n_cols(expr_); }
+
+    value_type at(std::size_t idx) const { return ExprTraits<E>::at(expr_, idx) * scalar_; }
+
+    value_type at(std::size_t row, std::size_t col) const { return ExprTraits<E>::at(expr_, row, col) * scalar_; }
+
+  private:
+    expr_storage_t<E> expr_;
+    value_type scalar_;
+};
+
+template <typename E>
+requires std::derived_from<E, ExprNode>
+struct ExprTraits<E> {
+    using value_type = typename E::value_type;
+    static constexpr ExprShape kShape = E::kShape;
+
+    static std::size_t size(const E& expr) { return expr.size(); }
+    static std::size_t n_rows(const E& expr) { return expr.n_rows(); }
+    static std::size_t n_cols(const E& expr) { return expr.n_cols(); }
+
+    static value_type at(const E& expr, std::size_t idx) { return expr.at(idx); }
+    static value_type at(const E& expr, std::size_t row, std::size_t col) { return expr.at(row, col); }
+};
+
+template <typename L, typename R>
+concept CompatibleExpressions = Expression<L> && Expression<R> &&
+    ExprTraits<L>::kShape == ExprTraits<R>::kShape && std::same_as<expr_value_t<L>, expr_value_t<R>>;
+
+template <Expression L, Expression R>
+bool same_extents(const L& left, const R& right) {
+    if constexpr (ExprTraits<L>::kShape == ExprShape::Array) {
+        return ExprTraits<L>::size(left) == ExprTraits<R>::size(right);
+    } else {
+        return ExprTraits<L>::n_rows(left) == ExprTraits<R>::n_rows(right) &&
+               ExprTraits<L>::n_cols(left) == ExprTraits<R>::n_cols(right);
+    }
+}
+
+// dst[idx] = expr[idx] for idx in [0, n)
+template <typename T, ExpressionOf<ExprShape::Array> E>
+void assign_elements(std::size_t n, T* dst, const E& expr) {
+    MTX_ELEMENTWISE_LOOP
+    for (std::size_t idx = 0; idx < n; ++idx) {
+        dst[idx] = ExprTraits<E>::at(expr, idx);
+    }
+}
+
+// dst[col] = expr(row, col) for col in [0, n_cols)
+template <typename T, ExpressionOf<ExprShape::Matrix> E>
+void assign_row(std::size_t row, std::size_t n_cols, T* dst, const E& expr) {
+    MTX_ELEMENTWISE_LOOP
+    for (std::size_t col = 0; col < n_cols; ++col) {
+        dst[col] = ExprTraits<E>::at(expr, row, col);
+    }
+}
+
+template <Expression L, Expression R>
+requires CompatibleExpressions<L, R>
+BinaryExpr<std::plus<>, L, R> operator+(const L& left, const R& right) {
+    assert(same_extents(left, right));
+    return {left, right};
+}
+
+template <Expression L, Expression R>
+requires CompatibleExpressions<L, R>
+BinaryExpr<std::minus<>, L, R> operator-(const L& left, const R& right) {
+    assert(same_extents(left, right));
+    return {left, right};
+}
+
+template <Expression E>
+ScaleExpr<E> operator*(const E& expr, const expr_value_t<E>& scalar) {
+    return {expr, scalar};
+}
+
+template <Expression E>
+ScaleExpr<E> operator*(const expr_value_t<E>& scalar, const E& expr) {
+    return {expr, scalar};
+}
+
+} // namespace mtx
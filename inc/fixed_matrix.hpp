@@ -0,0 +1,181 @@
+#pragma once
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <initializer_list>
+#include <ostream>
+#include <utility>
+
+#include "common.hpp"
+#include "matrix.hpp"
+
+namespace mtx {
+
+// R x C matrix with sizes known at compile time: storage lives inside the object (no heap),
+// every loop has constant bounds and all operations are usable in constant expressions
+template <FloatingPoint T, std::size_t R, std::size_t C>
+class FixedMatrix {
+  public: // constructors
+    constexpr FixedMatrix() = default;
+
+    constexpr FixedMatrix(std::initializer_list<std::initializer_list<T>> init_lists) {
+        assert(init_lists.size() == R);
+        std::size_t row = 0;
+        for (const auto& init_list : init_lists) {
+            assert(init_list.size() == C);
+            std::size_t col = 0;
+            for (const T& elem : init_list) {
+                (*this)[row][col++] = elem;
+            }
+            ++row;
+        }
+    }
+
+    // copies a dynamic matrix of the same shape
+    explicit FixedMatrix(const Matrix<T>& matrix) {
+        assert(matrix.n_rows() == R && matrix.n_cols() == C);
+        for (std::size_t row = 0; row < R; ++row) {
+            for (std::size_t col = 0; col < C; ++col) {
+                (*this)[row][col] = matrix[row][col];
+            }
+        }
+    }
+
+    static constexpr FixedMatrix identity() requires (R == C) {
+        FixedMatrix res_matrix;
+        for (std::size_t idx = 0; idx < R; ++idx) {
+            res_matrix[idx][idx] = T(1);
+        }
+        return res_matrix;
+    }
+
+  public: // getters
+    static constexpr std::size_t n_rows() { return R; }
+    static constexpr std::size_t n_cols() { return C; }
+
+    constexpr T* data() { return data_.data(); }
+    constexpr const T* data() const { return data_.data(); }
+
+  public: // operators
+    // rows are plain pointers, m[i][j] is a single indexed load
+    constexpr T* operator[](const std::size_t idx) { return data_.data() + idx * C; }
+    constexpr const T* operator[](const std::size_t idx) const { return data_.data() + idx * C; }
+
+    constexpr bool operator==(const FixedMatrix&) const = default;
+
+  public: // math
+    constexpr FixedMatrix<T, C, R> transpose() const {
+        FixedMatrix<T, C, R> res_matrix;
+        for (std::size_t row = 0; row < R; ++row) {
+            for (std::size_t col = 0; col < C; ++col) {
+                res_matrix[col][row] = (*this)[row][col];
+            }
+        }
+        return res_matrix;
+    }
+
+    // closed-form cofactor expansion up to 4 x 4, partial-pivoting elimination above;
+    // a pivot that compares equal to zero makes the determinant zero, as in Matrix::determinant()
+    constexpr T determinant() const requires (R == C) {
+        const FixedMatrix& m = *this;
+        if constexpr (R == 0) {
+            return T(1);
+        } else if constexpr (R == 1) {
+            return m[0][0];
+        } else if constexpr (R == 2) {
+            return m[0][0] * m[1][1] - m[0][1] * m[1][0];
+        } else if constexpr (R == 3) {
+            return m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1]) -
+                   m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0]) +
+                   m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+        } else if constexpr (R == 4) {
+            // 2 x 2 minors of the top and bottom row pairs (Laplace expansion along rows 0-1)
+            const T s0 = m[0][0] * m[1][1] - m[1][0] * m[0][1];
+            const T s1 = m[0][0] * m[1][2] - m[1][0] * m[0][2];
+            const T s2 = m[0][0] * m[1][3] - m[1][0] * m[0][3];
+            const T s3 = m[0][1] * m[1][2] - m[1][1] * m[0][2];
+            const T s4 = m[0][1] * m[1][3] - m[1][1] * m[0][3];
+            const T s5 = m[0][2] * m[1][3] - m[1][2] * m[0][3];
+
+            const T c5 = m[2][2] * m[3][3] - m[3][2] * m[2][3];
+            const T c4 = m[2][1] * m[3][3] - m[3][1] * m[2][3];
+            const T c3 = m[2][1] * m[3][2] - m[3][1] * m[2][2];
+            const T c2 = m[2][0] * m[3][3] - m[3][0] * m[2][3];
+            const T c1 = m[2][0] * m[3][2] - m[3][0] * m[2][2];
+            const T c0 = m[2][0] * m[3][1] - m[3][0] * m[2][1];
+
+            return s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+        } else {
+            return eliminate_determinant();
+        }
+    }
+
+  public:
+    Matrix<T> to_matrix() const {
+        return Matrix<T>(R, C, data_.begin(), data_.end());
+    }
+
+  private:
+    static constexpr T abs(const T val) { return val < T(0) ? -val : val; }
+
+    constexpr T eliminate_determinant() const {
+        FixedMatrix m = *this;
+        T res = T(1);
+        bool negative = false;
+
+        for (std::size_t col = 0; col < R; ++col) {
+            std::size_t pivot_row = col;
+            for (std::size_t row = col + 1; row < R; ++row) {
+                if (abs(m[row][col]) > abs(m[pivot_row][col])) {
+                    pivot_row = row;
+                }
+            }
+            if (m[pivot_row][col] == T(0)) {
+                return T(0);
+            }
+            if (pivot_row != col) {
+                for (std::size_t inner = col; inner < C; ++inner) {
+                    std::swap(m[col][inner], m[pivot_row][inner]);
+                }
+                negative = !negative;
+            }
+
+            for (std::size_t row = col + 1; row < R; ++row) {
+                const T mul = m[row][col] / m[col][col];
+                for (std::size_t inner = col + 1; inner < C; ++inner) {
+                    m[row][inner] -= mul * m[col][inner];
+                }
+            }
+            res *= m[col][col];
+        }
+
+        return negative ? -res : res;
+    }
+
+  private: // fields
+    std::array<T, R * C> data_{};
+};
+
+template <FloatingPoint T, std::size_t R, std::size_t K, std::size_t C>
+constexpr FixedMatrix<T, R, C> operator*(const FixedMatrix<T, R, K>& a, const FixedMatrix<T, K, C>& b) {
+    FixedMatrix<T, R, C> res_matrix;
+    for (std::size_t row = 0; row < R; ++row) {
+        for (std::size_t inner = 0; inner < K; ++inner) {
+            const T a_val = a[row][inner];
+            for (std::size_t col = 0; col < C; ++col) {
+                res_matrix[row][col] += a_val * b[inner][col];
+            }
+        }
+    }
+    return res_matrix;
+}
+
+template <FloatingPoint T, std::size_t R, std::size_t C>
+std::ostream& operator<<(std::ostream& ostream, const FixedMatrix<T, R, C>& matrix) {
+    ostream << matrix.to_matrix();
+
+    return ostream;
+}
+
+} // namespace mtx
@@ -0,0 +1,165 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include "kernels.hpp"
+#include "simd_kernels.hpp"
+#include "thread_pool.hpp"
+
+namespace mtx::kernels {
+
+namespace detail {
+
+// blocking parameters: a kc x nc panel of B and an mc x kc block of A are packed
+// so that the micro-kernel streams both from cache
+inline constexpr std::size_t kGemmMc = 96;
+inline constexpr std::size_t kGemmKc = 256;
+inline constexpr std::size_t kGemmNc = 2048;
+
+// C = beta * C, beta == 0 overwrites C so that garbage (NaN, inf) does not propagate
+template <typename T>
+inline void scale_output(std::size_t m, std::size_t n, T beta, T* c, std::size_t ldc) {
+    if (beta == T(1)) {
+        return;
+    }
+    for (std::size_t row = 0; row < m; ++row) {
+        if (beta == T(0)) {
+            std::fill_n(c + row * ldc, n, T(0));
+        } else {
+            scale(n, beta, c + row * ldc);
+        }
+    }
+}
+
+// packs columns [0, n) of a k x n block into panels of nr columns, zero-padding the last one;
+// element (i, j) of the block is b[i * rs + j * cs]
+template <typename T>
+inline void pack_b(std::size_t k, std::size_t n, std::size_t nr, const T* b, std::size_t rs, std::size_t cs, T* packed) {
+    for (std::size_t col_begin = 0; col_begin < n; col_begin += nr) {
+        const std::size_t n_cols = std::min(nr, n - col_begin);
+        for (std::size_t inner = 0; inner < k; ++inner) {
+            const T* b_row = b + inner * rs + col_begin * cs;
+            if (cs == 1) {
+                std::copy_n(b_row, n_cols, packed);
+            } else {
+                for (std::size_t col = 0; col < n_cols; ++col) {
+                    packed[col] = b_row[col * cs];
+                }
+            }
+            std::fill(packed + n_cols, packed + nr, T(0));
+            packed += nr;
+        }
+    }
+}
+
+// packs rows [0, m) of an m x k block into panels of mr rows stored column by column;
+// element (i, j) of the block is a[i * rs + j * cs]
+template <typename T>
+inline void pack_a(std::size_t m, std::size_t k, std::size_t mr, const T* a, std::size_t rs, std::size_t cs, T* packed) {
+    for (std::size_t row_begin = 0; row_begin < m; row_begin += mr) {
+        const std::size_t n_rows = std::min(mr, m - row_begin);
+        for (std::size_t inner = 0; inner < k; ++inner) {
+            for (std::size_t row = 0; row < n_rows; ++row) {
+                packed[row] = a[(row_begin + row) * rs + inner * cs];
+            }
+            std::fill(packed + n_rows, packed + mr, T(0));
+            packed += mr;
+        }
+    }
+}
+
+template <typename Kernel, typename T>
+void gemm_blocked(std::size_t m, std::size_t n, std::size_t k, T alpha, const T* a, std::size_t a_rs, std::size_t a_cs,
+                  const T* b, std::size_t b_rs, std::size_t b_cs, T* c, std::size_t ldc, ThreadPool* pool) {
+    constexpr std::size_t mr = Kernel::mr;
+    constexpr std::size_t nr = Kernel::nr;
+    constexpr std::size_t mc = (kGemmMc + mr - 1) / mr * mr;
+
+    std::vector<T> b_packed(kGemmKc * ((std::min(kGemmNc, n) + nr - 1) / nr * nr));
+    const std::size_t n_row_blocks = (m + mc - 1) / mc;
+
+    for (std::size_t col_block = 0; col_block < n; col_block += kGemmNc) {
+        const std::size_t nc = std::min(kGemmNc, n - col_block);
+
+        for (std::size_t inner_block = 0; inner_block < k; inner_block += kGemmKc) {
+            const std::size_t kc = std::min(kGemmKc, k - inner_block);
+            pack_b(kc, nc, nr, b + inner_block * b_rs + col_block * b_cs, b_rs, b_cs, b_packed.data());
+
+            // output row blocks are independent, each one packs its own block of A
+            auto run_row_blocks = [&](std::size_t block_begin, std::size_t block_end) {
+                std::vector<T> a_packed(mc * kc);
+                for (std::size_t block = block_begin; block < block_end; ++block) {
+                    const std::size_t row_block = block * mc;
+                    const std::size_t rows = std::min(mc, m - row_block);
+                    pack_a(rows, kc, mr, a + row_block * a_rs + inner_block * a_cs, a_rs, a_cs, a_packed.data());
+
+                    for (std::size_t col = 0; col < nc; col += nr) {
+                        for (std::size_t row = 0; row < rows; row += mr) {
+                            Kernel::micro_kernel(kc, a_packed.data() + row * kc, b_packed.data() + col * kc, alpha,
+                                                 c + (row_block + row) * ldc + col_block + col, ldc,
+                                                 std::min(mr, rows - row), std::min(nr, nc - col));
+                        }
+                    }
+                }
+            };
+
+            if (pool == nullptr) {
+                run_row_blocks(0, n_row_blocks);
+            } else {
+                pool->parallel_for(0, n_row_blocks, 1, run_row_blocks);
+            }
+        }
+    }
+}
+
+} // namespace detail
+
+// C = alpha * A * B + beta * C for m x k A, k x n B and row-major m x n C, where element (i, j) of A is
+// a[i * a_rs + j * a_cs] and the same for B, so transposed operands are read in place while packing;
+// C must not overlap A or B; output row blocks are spread over the pool when one is given
+template <typename T>
+void gemm(std::size_t m, std::size_t n, std::size_t k, T alpha, const T* a, std::size_t a_rs, std::size_t a_cs,
+          const T* b, std::size_t b_rs, std::size_t b_cs, T beta, T* c, std::size_t ldc, ThreadPool* pool = nullptr) {
+    if (m == 0 || n == 0) {
+        return;
+    }
+    detail::scale_output(m, n, beta, c, ldc);
+    if (k == 0 || alpha == T(0)) {
+        return;
+    }
+
+    if constexpr (SimdScalar<T>) {
+        switch (simd_level()) {
+#ifdef MTX_SIMD_X86
+            case SimdLevel::AVX512:
+                return detail::gemm_blocked<avx512::GemmKernel<T>>(m, n, k, alpha, a, a_rs, a_cs, b, b_rs, b_cs, c, ldc, pool);
+            case SimdLevel::AVX2:
+                return detail::gemm_blocked<avx2::GemmKernel<T>>(m, n, k, alpha, a, a_rs, a_cs, b, b_rs, b_cs, c, ldc, pool);
+            case SimdLevel::SSE2:
+                return detail::gemm_blocked<sse2::GemmKernel<T>>(m, n, k, alpha, a, a_rs, a_cs, b, b_rs, b_cs, c, ldc, pool);
+#endif
+            default:
+                return detail::gemm_blocked<scalar::GemmKernel<T>>(m, n, k, alpha, a, a_rs, a_cs, b, b_rs, b_cs, c, ldc, pool);
+        }
+    } else {
+        for (std::size_t row = 0; row < m; ++row) {
+            for (std::size_t inner = 0; inner < k; ++inner) {
+                const T mul = alpha * a[row * a_rs + inner * a_cs];
+                for (std::size_t col = 0; col < n; ++col) {
+                    c[row * ldc + col] += mul * b[inner * b_rs + col * b_cs];
+                }
+            }
+        }
+    }
+}
+
+// row-major A, B and C with leading dimensions lda, ldb and ldc
+template <typename T>
+void gemm(std::size_t m, std::size_t n, std::size_t k, T alpha, const T* a, std::size_t lda,
+          const T* b, std::size_t ldb, T beta, T* c, std::size_t ldc, ThreadPool* pool = nullptr) {
+    gemm(m, n, k, alpha, a, lda, std::size_t(1), b, ldb, std::size_t(1), beta, c, ldc, pool);
+}
+
+} // namespace mtx::kernels
@@ -4,37 +4,76 @@
 #include <utility>
 #include <iostream>
 #include <iterator>
+#include <cassert>
+#include <memory>
+
+#include "allocators.hpp"
+#include "expression.hpp"
+#include "kernels.hpp"
+#include "stats.hpp"
 
 namespace mtx {
 
 template<typename Iter, typename T>
 concept IteratorOf = std::same_as<std::iter_value_t<Iter>, T>;
 
-template<typename T>
+template<typename T, typename Alloc = std::allocator<T>>
 class Array {
   public:
+    using allocator_type = Alloc;
+
     Array() = default;
 
-    Array(std::initializer_list<T> init_list) : size_(init_list.size()), data_(allocate(size())) {
-        std::copy(init_list.begin(), init_list.end(), data_);
+    explicit Array(const Alloc& alloc) : alloc_(alloc) {}
+
+    Array(std::initializer_list<T> init_list, const Alloc& alloc = Alloc())
+        : alloc_(alloc), size_(init_list.size()), capacity_(size_), data_(allocate(capacity_))
+    {
+        std::uninitialized_copy(init_list.begin(), init_list.end(), data_);
     }
 
+    // missing elements are value-initialized
     template <typename Iter>
     requires IteratorOf<Iter, T>
-    Array(std::size_t size, Iter elems_begin, Iter elems_end) : size_(size), data_(allocate(size)) {
-        std::copy(elems_begin, elems_end, data_);
+    Array(std::size_t size, Iter elems_begin, Iter elems_end, const Alloc& alloc = Alloc())
+        : alloc_(alloc), size_(size), capacity_(size), data_(allocate(size))
+    {
+        std::size_t idx = 0;
+        for (auto elem_it = elems_begin; idx < size && elem_it != elems_end; ++idx, ++elem_it) {
+            std::construct_at(data_ + idx, *elem_it);
+        }
+        std::uninitialized_value_construct(data_ + idx, data_ + size);
     }
 
-    Array(std::size_t size, const T& value = T{}) {
-        reallocate_and_fill(size, value);
+    Array(std::size_t size, const T& value = T{}, const Alloc& alloc = Alloc())
+        : alloc_(alloc), size_(size), capacity_(size), data_(allocate(size))
+    {
+        std::uninitialized_fill_n(data_, size, value);
+    }
+
+    // storage for size elements, trivially constructible ones are left unset
+    Array(std::size_t size, Uninitialized, const Alloc& alloc = Alloc())
+        : alloc_(alloc), size_(size), capacity_(size), data_(allocate(size))
+    {
+        std::uninitialized_default_construct_n(data_, size);
+    }
+
+    // evaluates a lazy expression such as a + b * s - c in a single pass
+    template <ExpressionOf<ExprShape::Array> E>
+    requires std::derived_from<E, ExprNode> && std::same_as<expr_value_t<E>, T>
+    Array(const E& expr, const Alloc& alloc = Alloc()) : Array(ExprTraits<E>::size(expr), kUninitialized, alloc) {
+        assign_elements(size(), data_, expr);
     }
 
   public:
-    Array(const Array& other) : size_(other.size()), data_(allocate(size())) {
-        std::copy(other.begin(), other.end(), data_);
+    Array(const Array& other)
+        : alloc_(std::allocator_traits<Alloc>::select_on_container_copy_construction(other.alloc_)),
+          size_(other.size()), capacity_(size_), data_(allocate(capacity_))
+    {
+        std::uninitialized_copy(other.begin(), other.end(), data_);
     }
 
-    Array(Array&& other) {
+    Array(Array&& other) noexcept : alloc_(other.alloc_) {
         swap(other);
     }
 
@@ -49,7 +88,7 @@ class Array {
         return *this;
     }
 
-    Array& operator=(Array&& other) {
+    Array& operator=(Array&& other) noexcept {
         if(this == &other) {
             return *this;
         }
@@ -59,7 +98,21 @@ class Array {
         return *this;
     }
 
-    ~Array() { deallocate(data_); }
+    // the expression may reference this array, elements are only overwritten at their own index
+    template <ExpressionOf<ExprShape::Array> E>
+    requires std::derived_from<E, ExprNode> && std::same_as<expr_value_t<E>, T>
+    Array& operator=(const E& expr) {
+        if (ExprTraits<E>::size(expr) != size()) {
+            Array temp(expr, alloc_);
+            swap(temp);
+        } else {
+            assign_elements(size(), data_, expr);
+        }
+
+        return *this;
+    }
+
+    ~Array() { deallocate(data_, size_, capacity_); }
 
   public:
     T& operator[](std::size_t idx) { return data_[idx]; }
@@ -73,48 +126,71 @@ class Array {
 
   public:
     std::size_t size() const { return size_; }
+    std::size_t capacity() const { return capacity_; }
 
     bool empty() const { return size() == 0; }
 
+    Alloc get_allocator() const { return alloc_; }
+
   public:
     const Array& operator+=(const Array& other) {
-        std::transform(begin(), end(), other.begin(), begin(), std::plus<T>());
+        kernels::add(size(), other.begin(), begin());
         return *this;
     }
 
-    Array operator+(const Array& other) const {
-        Array temp(*this);
-        temp += other;
-        return temp;
-    }
-
     const Array& operator-=(const Array& other) {
-        std::transform(begin(), end(), other.begin(), begin(), std::minus<T>());
+        kernels::sub(size(), other.begin(), begin());
         return *this;
     }
 
-    Array operator-(const Array& other) const {
-        Array temp(*this);
-        temp -= other;
-        return temp;
+    const Array& operator*=(const T& scalar) {
+        kernels::scale(size(), scalar, begin());
+        return *this;
     }
 
-    const Array& operator*=(const T& scalar) {
-        for (std::size_t i = 0; i < size(); ++i) {
-            (*this)[i] *= scalar;
-        }
+    // this[i] += mul * src[i] for i in [first, last), without temporaries
+    const Array& axpy(const T& mul, const Array& src, std::size_t first, std::size_t last) {
+        assert(first <= last && last <= size() && last <= src.size());
+        kernels::axpy(last - first, mul, src.begin() + first, begin() + first);
         return *this;
     }
 
-    Array operator*(const T& scalar) const {
-        Array temp(*this);
-        temp *= scalar;
-        return temp;
+    const Array& axpy(const T& mul, const Array& src) {
+        return axpy(mul, src, 0, size());
     }
 
   public:
+    // growing past capacity() at least doubles it, so growing one element at a time is amortized O(1);
+    // shrinking keeps the storage, see shrink_to_fit()
     void resize(std::size_t new_size, const T& value = T{}) {
-        reallocate_and_fill(new_size, value);
+        if (new_size <= size()) {
+            std::destroy(begin() + new_size, end());
+            size_ = new_size;
+            return;
+        }
+
+        if (new_size > capacity()) {
+            // new elements are built before the old ones move, value may refer to one of them
+            const std::size_t new_capacity = std::max(new_size, 2 * capacity());
+            T* new_buffer = allocate(new_capacity);
+            std::uninitialized_fill(new_buffer + size(), new_buffer + new_size, value);
+            replace_buffer(new_buffer, new_capacity);
+        } else {
+            std::uninitialized_fill(end(), begin() + new_size, value);
+        }
+        size_ = new_size;
+    }
+
+    void reserve(std::size_t new_capacity) {
+        if (new_capacity > capacity()) {
+            reallocate(new_capacity);
+        }
+    }
+
+    void shrink_to_fit() {
+        if (capacity() > size()) {
+            reallocate(size());
+        }
     }
 
     void fill(const T& value) {
@@ -122,78 +198,93 @@ class Array {
     }
 
   private:
-    void swap(Array& other) {
+    // buffers always travel together with the allocator that owns them
+    void swap(Array& other) noexcept {
+        std::swap(alloc_, other.alloc_);
         std::swap(data_, other.data_);
         std::swap(size_, other.size_);
+        std::swap(capacity_, other.capacity_);
     }
 
-    static T* allocate(std::size_t capacity) {
-        return new T[capacity];
-    }
-    static void deallocate(T* data) {
-        delete[] data;
+    T* allocate(std::size_t capacity) {
+        if (capacity == 0) {
+            return nullptr;
+        }
+        stats::add(stats::Counter::Allocations);
+        stats::add(stats::Counter::AllocatedBytes, capacity * sizeof(T));
+        return std::allocator_traits<Alloc>::allocate(alloc_, capacity);
     }
 
-    void reallocate(std::size_t new_size) {
-        if (new_size == size()) {
+    void deallocate(T* data, std::size_t size, std::size_t capacity) {
+        if (data == nullptr) {
             return;
         }
-
-        T* new_buffer = allocate(new_size);
-
-        if (begin() != nullptr) {
-            std::size_t n_to_copy = std::min(size_, new_size);
-            std::copy(begin(), begin() + n_to_copy, new_buffer);
-            deallocate(data_);
-        }
-
-        data_ = new_buffer;
-        size_ = new_size;
+        std::destroy_n(data, size);
+        std::allocator_traits<Alloc>::deallocate(alloc_, data, capacity);
     }
 
-    void reallocate_and_fill(std::size_t new_size, const T& value = T{}) {
-        std::size_t old_size = size();
-
-        reallocate(new_size);
+    // moves the elements into a buffer of new_capacity >= size() elements,
+    // rows of a JaggedArray are handed over without copying their contents
+    void reallocate(std::size_t new_capacity) {
+        assert(new_capacity >= size());
+        replace_buffer(allocate(new_capacity), new_capacity);
+    }
 
-        T* first = begin() + old_size;
-        T* last  = begin() + new_size;
+    void replace_buffer(T* new_buffer, std::size_t new_capacity) {
+        std::uninitialized_move(begin(), end(), new_buffer);
 
-        if (last > first) {
-            std::fill(first, last, value);
-        }
+        deallocate(data_, size_, capacity_);
+        data_ = new_buffer;
+        capacity_ = new_capacity;
     }
 
   private:
+    [[no_unique_address]] Alloc alloc_{};
     std::size_t size_ = 0;
+    std::size_t capacity_ = 0;
     T* data_ = nullptr;
 };
 
-template <typename T>
-inline std::ostream& operator<<(std::ostream& ostream, const Array<T>& array) {
+// a + b, a - b and a * s are lazy, see expression.hpp
+template <typename T, typename Alloc>
+struct ExprTraits<Array<T, Alloc>> {
+    using value_type = T;
+    static constexpr ExprShape kShape = ExprShape::Array;
+
+    static std::size_t size(const Array<T, Alloc>& array) { return array.size(); }
+    static const T& at(const Array<T, Alloc>& array, std::size_t idx) { return array.begin()[idx]; }
+};
+
+template <typename T, typename Alloc>
+inline std::ostream& operator<<(std::ostream& ostream, const Array<T, Alloc>& array) {
     std::copy(array.begin(), array.end() - 1, std::ostream_iterator<T>(ostream, ", "));
     ostream << *(array.end() - 1);
     return ostream;
 }
 
-template <typename T>
+template <typename T, typename Alloc = std::allocator<T>>
 class JaggedArray {
   public:
+    using allocator_type = Alloc;
+    using Row = Array<T, Alloc>;
+
     JaggedArray() = default;
 
-    JaggedArray(std::initializer_list<std::initializer_list<T>> init_lists) 
-        : data_(init_lists.size()) 
+    JaggedArray(std::initializer_list<std::initializer_list<T>> init_lists, const Alloc& alloc = Alloc())
+        : data_(init_lists.size(), Row(alloc), RowAlloc(alloc))
     {
         std::size_t row_idx = 0;
         for (const auto& row_list : init_lists) {
-            data_[row_idx] = Array<T>(row_list);
+            data_[row_idx] = Row(row_list, alloc);
             ++row_idx;
         }
     }
 
     template<typename Iter>
     requires IteratorOf<Iter, std::size_t>
-    JaggedArray(std::size_t n_rows, Iter rows_sizes_begin, Iter rows_sizes_end, const T& elem = T{}) : data_(n_rows) {
+    JaggedArray(std::size_t n_rows, Iter rows_sizes_begin, Iter rows_sizes_end, const T& elem = T{}, const Alloc& alloc = Alloc())
+        : data_(n_rows, Row(alloc), RowAlloc(alloc))
+    {
         auto it = rows_sizes_begin;
         for (std::size_t row_idx = 0; row_idx < n_rows; ++row_idx, ++it) {
             data_[row_idx].resize(*it, elem);
@@ -202,40 +293,38 @@ class JaggedArray {
 
     template<typename Iter1, typename Iter2>
     requires IteratorOf<Iter1, std::size_t> && IteratorOf<Iter2, T>
-    JaggedArray(std::size_t n_rows, Iter1 rows_sizes_begin, Iter1 rows_sizes_end, Iter2 elems_begin, Iter2 elems_end) 
-        : JaggedArray(n_rows, rows_sizes_begin, rows_sizes_end) 
+    JaggedArray(std::size_t n_rows, Iter1 rows_sizes_begin, Iter1 rows_sizes_end, Iter2 elems_begin, Iter2 elems_end,
+                const Alloc& alloc = Alloc())
+        : JaggedArray(n_rows, rows_sizes_begin, rows_sizes_end, T{}, alloc)
     {    
         fill_from_iter(elems_begin, elems_end);
     }
 
-    JaggedArray(std::size_t n_rows, std::size_t row_size, const T& elem = T{}) : data_(n_rows) {
-        for (std::size_t row_idx = 0; row_idx < n_rows; ++row_idx) {
-            data_[row_idx].resize(row_size, elem);
-        }
-    }
+    JaggedArray(std::size_t n_rows, std::size_t row_size, const T& elem = T{}, const Alloc& alloc = Alloc())
+        : data_(n_rows, Row(row_size, elem, alloc), RowAlloc(alloc)) {}
 
     template<typename Iter>
     requires IteratorOf<Iter, T>
-    JaggedArray(std::size_t n_rows, std::size_t rows_size, Iter elems_begin, Iter elems_end) 
-        : JaggedArray(n_rows, rows_size)
+    JaggedArray(std::size_t n_rows, std::size_t rows_size, Iter elems_begin, Iter elems_end, const Alloc& alloc = Alloc())
+        : JaggedArray(n_rows, rows_size, T{}, alloc)
     {
         fill_from_iter(elems_begin, elems_end);
     }
 
   public:
-    Array<T>& operator[](std::size_t idx) {
+    Row& operator[](std::size_t idx) {
         return data_[idx];
     }
 
-    const Array<T>& operator[](std::size_t idx) const {
+    const Row& operator[](std::size_t idx) const {
         return data_[idx];
     }
 
-    Array<T>* begin() { return data_.begin(); } 
-    const Array<T>* begin() const { return data_.begin(); } 
+    Row* begin() { return data_.begin(); } 
+    const Row* begin() const { return data_.begin(); } 
 
-    Array<T>* end() { return data_.end(); } 
-    const Array<T>* end() const { return data_.end(); } 
+    Row* end() { return data_.end(); } 
+    const Row* end() const { return data_.end(); } 
 
   public:
     bool empty() const { return data_.empty(); }
@@ -244,9 +333,23 @@ class JaggedArray {
         return data_.size();
     }
 
+    Alloc get_allocator() const { return Alloc(data_.get_allocator()); }
+
   public:
     void resize(std::size_t new_size) {
-        data_.resize(new_size);
+        data_.resize(new_size, Row(get_allocator()));
+    }
+
+    // storage for new_n_rows rows, growing up to it moves no rows
+    void reserve(std::size_t new_n_rows) {
+        data_.reserve(new_n_rows);
+    }
+
+    void shrink_to_fit() {
+        data_.shrink_to_fit();
+        for (Row& row : data_) {
+            row.shrink_to_fit();
+        }
     }
 
     void resize_row(std::size_t row_idx, std::size_t new_size) {
@@ -257,6 +360,11 @@ class JaggedArray {
         std::swap(data_[first_idx], data_[second_idx]);
     }
 
+    // row[dst] += mul * row[src] on columns [first_col, last_col)
+    void axpy_rows(std::size_t dst_idx, std::size_t src_idx, const T& mul, std::size_t first_col, std::size_t last_col) {
+        data_[dst_idx].axpy(mul, data_[src_idx], first_col, last_col);
+    }
+
   private:
     template<typename Iter>
     void fill_from_iter(Iter begin, Iter end) {
@@ -270,40 +378,43 @@ class JaggedArray {
     }
 
   protected:
-    Array<Array<T>> data_{};
+    using RowAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<Row>;
+
+    Array<Row, RowAlloc> data_{};
 };
 
-template <typename T>
-inline std::ostream& operator<<(std::ostream& ostream, const JaggedArray<T>& array) {
-    std::copy(array.begin(), array.end() - 1, std::ostream_iterator<Array<T>>(ostream, "\n"));
+template <typename T, typename Alloc>
+inline std::ostream& operator<<(std::ostream& ostream, const JaggedArray<T, Alloc>& array) {
+    std::copy(array.begin(), array.end() - 1, std::ostream_iterator<Array<T, Alloc>>(ostream, "\n"));
     ostream << *(array.end() - 1);
     return ostream;
 }
 
-template <typename T>
-class RectangularArray : private JaggedArray<T> {
+template <typename T, typename Alloc = std::allocator<T>>
+class RectangularArray : private JaggedArray<T, Alloc> {
   public:
     RectangularArray() = default;
 
-    RectangularArray(std::initializer_list<std::initializer_list<T>> init_lists)
-        : JaggedArray<T>(init_lists) {}
+    RectangularArray(std::initializer_list<std::initializer_list<T>> init_lists, const Alloc& alloc = Alloc())
+        : JaggedArray<T, Alloc>(init_lists, alloc) {}
 
-    RectangularArray(std::size_t n_rows, std::size_t n_cols, const T& elem = T{}) 
-        : JaggedArray<T>(n_rows, n_cols, elem) {}
+    RectangularArray(std::size_t n_rows, std::size_t n_cols, const T& elem = T{}, const Alloc& alloc = Alloc()) 
+        : JaggedArray<T, Alloc>(n_rows, n_cols, elem, alloc) {}
 
     template<typename Iter>
     requires IteratorOf<Iter, T>
-    RectangularArray(std::size_t n_rows, std::size_t n_cols, Iter elems_begin, Iter elems_end) 
-        : JaggedArray<T>(n_rows, n_cols, elems_begin, elems_end) {}
+    RectangularArray(std::size_t n_rows, std::size_t n_cols, Iter elems_begin, Iter elems_end, const Alloc& alloc = Alloc()) 
+        : JaggedArray<T, Alloc>(n_rows, n_cols, elems_begin, elems_end, alloc) {}
 
   public:
-    using JaggedArray<T>::operator[];
-    using JaggedArray<T>::begin;
-    using JaggedArray<T>::end;
+    using JaggedArray<T, Alloc>::operator[];
+    using JaggedArray<T, Alloc>::begin;
+    using JaggedArray<T, Alloc>::end;
     
   public:
-    using JaggedArray<T>::empty;
-    using JaggedArray<T>::n_rows;
+    using JaggedArray<T, Alloc>::empty;
+    using JaggedArray<T, Alloc>::n_rows;
+    using JaggedArray<T, Alloc>::get_allocator;
 
     std::size_t n_cols() const {
         if (this->empty()) {
@@ -314,15 +425,17 @@ class RectangularArray : private JaggedArray<T> {
     }
 
   public:  
-    using JaggedArray<T>::swap_rows;
+    using JaggedArray<T, Alloc>::swap_rows;
+    using JaggedArray<T, Alloc>::axpy_rows;
+    using JaggedArray<T, Alloc>::reserve;
+    using JaggedArray<T, Alloc>::shrink_to_fit;
 
-    void resize(std::size_t new_size, const T& value = T{}) {
-        std::size_t old_size = n_rows();
+    void axpy_rows(std::size_t dst_idx, std::size_t src_idx, const T& mul, std::size_t first_col = 0) {
+        axpy_rows(dst_idx, src_idx, mul, first_col, n_cols());
+    }
 
-        data_.resize(new_size);
-        for (std::size_t i = old_size; i < new_size; ++i) {
-            data_[i] = Array<T>(n_cols(), value);
-        }
+    void resize(std::size_t new_size, const T& value = T{}) {
+        data_.resize(new_size, Row(n_cols(), value, get_allocator()));
     }
 
     void resize_rows(std::size_t new_size, const T& value = T{}) {
@@ -332,12 +445,13 @@ class RectangularArray : private JaggedArray<T> {
     }
 
   private:
-    using JaggedArray<T>::data_;
+    using typename JaggedArray<T, Alloc>::Row;
+    using JaggedArray<T, Alloc>::data_;
 };
 
-template <typename T>
-inline std::ostream& operator<<(std::ostream& ostream, const RectangularArray<T>& array) {
-    std::copy(array.begin(), array.end() - 1, std::ostream_iterator<Array<T>>(ostream, "\n"));
+template <typename T, typename Alloc>
+inline std::ostream& operator<<(std::ostream& ostream, const RectangularArray<T, Alloc>& array) {
+    std::copy(array.begin(), array.end() - 1, std::ostream_iterator<Array<T, Alloc>>(ostream, "\n"));
     ostream << *(array.end() - 1);
     return ostream;
 }
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+
+#include "simd_kernels.hpp"
+
+namespace mtx::kernels {
+
+// Element-wise kernels over raw buffers. float and double go to the SIMD implementation
+// of the instruction set picked at runtime (see simd_level()), other types use plain loops.
+// x and y must either be the same pointer or not overlap.
+
+// y[i] += x[i]
+template <typename T>
+inline void add(std::size_t n, const T* x, T* y) {
+    if constexpr (SimdScalar<T>) {
+        switch (simd_level()) {
+#ifdef MTX_SIMD_X86
+            case SimdLevel::AVX512: return avx512::add(n, x, y);
+            case SimdLevel::AVX2:   return avx2::add(n, x, y);
+            case SimdLevel::SSE2:   return sse2::add(n, x, y);
+#endif
+            default: return scalar::add(n, x, y);
+        }
+    } else {
+        for (std::size_t i = 0; i < n; ++i) {
+            y[i] += x[i];
+        }
+    }
+}
+
+// y[i] -= x[i]
+template <typename T>
+inline void sub(std::size_t n, const T* x, T* y) {
+    if constexpr (SimdScalar<T>) {
+        switch (simd_level()) {
+#ifdef MTX_SIMD_X86
+            case SimdLevel::AVX512: return avx512::sub(n, x, y);
+            case SimdLevel::AVX2:   return avx2::sub(n, x, y);
+            case SimdLevel::SSE2:   return sse2::sub(n, x, y);
+#endif
+            default: return scalar::sub(n, x, y);
+        }
+    } else {
+        for (std::size_t i = 0; i < n; ++i) {
+            y[i] -= x[i];
+        }
+    }
+}
+
+// y[i] *= alpha
+template <typename T>
+inline void scale(std::size_t n, const T& alpha, T* y) {
+    if constexpr (SimdScalar<T>) {
+        switch (simd_level()) {
+#ifdef MTX_SIMD_X86
+            case SimdLevel::AVX512: return avx512::scale(n, alpha, y);
+            case SimdLevel::AVX2:   return avx2::scale(n, alpha, y);
+            case SimdLevel::SSE2:   return sse2::scale(n, alpha, y);
+#endif
+            default: return scalar::scale(n, alpha, y);
+        }
+    } else {
+        for (std::size_t i = 0; i < n; ++i) {
+            y[i] *= alpha;
+        }
+    }
+}
+
+// y[i] += alpha * x[i]
+template <typename T>
+inline void axpy(std::size_t n, const T& alpha, const T* x, T* y) {
+    if constexpr (SimdScalar<T>) {
+        switch (simd_level()) {
+#ifdef MTX_SIMD_X86
+            case SimdLevel::AVX512: return avx512::axpy(n, alpha, x, y);
+            case SimdLevel::AVX2:   return avx2::axpy(n, alpha, x, y);
+            case SimdLevel::SSE2:   return sse2::axpy(n, alpha, x, y);
+#endif
+            default: return scalar::axpy(n, alpha, x, y);
+        }
+    } else {
+        for (std::size_t i = 0; i < n; ++i) {
+            y[i] += alpha * x[i];
+        }
+    }
+}
+
+// y[block * lanes + lane] += alpha[lane] * x[block * lanes + lane] for block in [0, n_blocks)
+template <std::size_t lanes, typename T>
+inline void lane_axpy(std::size_t n_blocks, const T* alpha, const T* x, T* y) {
+    if constexpr (SimdScalar<T>) {
+        switch (simd_level()) {
+#ifdef MTX_SIMD_X86
+            case SimdLevel::AVX512: return avx512::lane_axpy<lanes>(n_blocks, alpha, x, y);
+            case SimdLevel::AVX2:   return avx2::lane_axpy<lanes>(n_blocks, alpha, x, y);
+            case SimdLevel::SSE2:   return sse2::lane_axpy<lanes>(n_blocks, alpha, x, y);
+#endif
+            default: return scalar::lane_axpy<lanes>(n_blocks, alpha, x, y);
+        }
+    } else {
+        for (std::size_t block = 0; block < n_blocks; ++block) {
+            for (std::size_t lane = 0; lane < lanes; ++lane) {
+                y[block * lanes + lane] += alpha[lane] * x[block * lanes + lane];
+            }
+        }
+    }
+}
+
+// index of the first of x[0], x[stride], ..., x[(n - 1) * stride] with the largest absolute value;
+// strided (column) walks touch one element per cache line, so they stay scalar
+template <typename T>
+inline std::size_t iamax(std::size_t n, const T* x, std::size_t stride = 1) {
+    if constexpr (SimdScalar<T>) {
+        if (stride == 1) {
+            switch (simd_level()) {
+#ifdef MTX_SIMD_X86
+                case SimdLevel::AVX512: return avx512::iamax(n, x);
+                case SimdLevel::AVX2:   return avx2::iamax(n, x);
+                case SimdLevel::SSE2:   return sse2::iamax(n, x);
+#endif
+                default: return scalar::iamax(n, x);
+            }
+        }
+    }
+
+    if (n == 0) {
+        return 0;
+    }
+
+    std::size_t result_idx = 0;
+    auto result_value = std::fabs(x[0]);
+    for (std::size_t idx = 1; idx < n; ++idx) {
+        auto cur_val = std::fabs(x[idx * stride]);
+        if (cur_val > result_value) {
+            result_value = cur_val;
+            result_idx = idx;
+        }
+    }
+    return result_idx;
+}
+
+} // namespace mtx::kernels
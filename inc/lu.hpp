@@ -0,0 +1,537 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <numbers>
+#include <optional>
+#include <utility>
+
+#include "allocators.hpp"
+#include "common.hpp"
+#include "dense_array.hpp"
+#include "gemm.hpp"
+#include "jagged_array.hpp"
+#include "kernels.hpp"
+#include "matrix_view.hpp"
+#include "stats.hpp"
+#include "task_scheduler.hpp"
+#include "thread_pool.hpp"
+
+namespace mtx {
+
+// det = sign * exp(log_abs), sign is 0 and log_abs is -inf for a singular matrix
+template <FloatingPoint T>
+struct LogDeterminant {
+    T sign;
+    T log_abs;
+};
+
+// a product of many factors as mantissa * 2^exponent, 0.5 <= |mantissa| < 1: renormalizing after
+// every factor keeps the running product away from overflow and underflow
+template <FloatingPoint T>
+struct ScaledProduct {
+    T mantissa = T(1);
+    long long exponent = 0;
+
+    void multiply(const T factor) {
+        int factor_exponent = 0;
+        mantissa = std::frexp(mantissa * factor, &factor_exponent);
+        exponent += factor_exponent;
+    }
+};
+
+// sign * product, overflows to inf or underflows to 0 only when the value itself is out of T's range
+template <FloatingPoint T>
+T scaled_determinant(const ScaledProduct<T>& product, const int sign) {
+    const long long exponent = std::clamp<long long>(product.exponent, std::numeric_limits<int>::min(),
+                                                     std::numeric_limits<int>::max());
+    return std::ldexp(product.mantissa * T(sign), static_cast<int>(exponent));
+}
+
+// the same as a logarithm, stays finite for any size
+template <FloatingPoint T>
+LogDeterminant<T> scaled_log_determinant(const ScaledProduct<T>& product, const int sign) {
+    if (product.mantissa == T(0)) {
+        return {T(0), -std::numeric_limits<T>::infinity()};
+    }
+    const T log_abs = std::log(std::fabs(product.mantissa)) +
+                      static_cast<T>(product.exponent) * std::numbers::ln2_v<T>;
+    return {(product.mantissa < 0 ? T(-1) : T(1)) * T(sign), log_abs};
+}
+
+namespace detail {
+
+// columns handed to one thread by the column-parallel loops
+inline constexpr std::size_t kColumnTile = 256;
+
+// runs func over [begin, end) on the pool, or inline without one
+template <typename Func>
+void for_range(ThreadPool* pool, std::size_t begin, std::size_t end, std::size_t grain, Func&& func) {
+    if (pool == nullptr) {
+        func(begin, end);
+        return;
+    }
+    pool->parallel_for(begin, end, grain, func);
+}
+
+struct PanelPivoting {
+    int sign = 1;
+    bool singular = false;
+};
+
+// Unblocked elimination with partial pivoting of an n_rows x width panel whose element (0, 0) lies
+// on the diagonal, only the panel's columns are touched. The panel row i is row first_row + i of the
+// whole matrix: pivots[col] gets the row swapped with it and swap_rows(a, b) exchanges two rows
+// wherever the caller needs them swapped. A zero pivot leaves a zero column below the diagonal.
+template <FloatingPoint T, typename SwapRows>
+PanelPivoting factor_panel(T* panel, const std::size_t ld, const std::size_t n_rows, const std::size_t width,
+                           const std::size_t first_row, std::size_t* pivots, SwapRows&& swap_rows) {
+    PanelPivoting res;
+    auto row_ptr = [&](std::size_t row) { return panel + row * ld; };
+
+    for (std::size_t col = 0; col < width; ++col) {
+        stats::add(stats::Counter::PivotSearches);
+        const std::size_t pivot_row = col + kernels::iamax(n_rows - col, row_ptr(col) + col, ld);
+        pivots[col] = first_row + pivot_row;
+        if (pivot_row != col) {
+            swap_rows(first_row + pivot_row, first_row + col);
+            res.sign = -res.sign;
+            stats::add(stats::Counter::RowSwaps);
+        }
+
+        // only an exact zero: the largest element of a column of tiny but exact values is a valid
+        // pivot, an absolute threshold would call every matrix with small entries singular
+        const T* pivot_ptr = row_ptr(col);
+        const T pivot = pivot_ptr[col];
+        if (pivot == T(0)) {
+            res.singular = true;
+            for (std::size_t row = col + 1; row < n_rows; ++row) {
+                row_ptr(row)[col] = T(0);
+            }
+            continue;
+        }
+
+        // a division and an axpy over the rest of the panel for every row below
+        stats::add(stats::Counter::Flops, (n_rows - col - 1) * (2 * (width - col - 1) + 1));
+        for (std::size_t row = col + 1; row < n_rows; ++row) {
+            T* current = row_ptr(row);
+            const T mul = current[col] / pivot;
+            current[col] = mul;
+            kernels::axpy(width - col - 1, -mul, pivot_ptr + col + 1, current + col + 1);
+        }
+    }
+    return res;
+}
+
+// B = L^-1 * B, L is the unit lower triangle of the n x n block at l, B is n x n_cols.
+// Recursive TRSM: solves the top half, one GEMM removes it from the bottom half, solves the bottom half;
+// blocks of at most leaf rows are solved with row axpys, in parallel over column tiles of B
+template <FloatingPoint T>
+void solve_unit_lower(const T* l, const std::size_t ld_l, const std::size_t n, T* b, const std::size_t ld_b,
+                      const std::size_t n_cols, const std::size_t leaf, ThreadPool* pool) {
+    if (n <= leaf) {
+        stats::add(stats::Counter::Flops, n * (n - 1) * n_cols);
+        for_range(pool, 0, n_cols, kColumnTile, [&](std::size_t col_begin, std::size_t col_end) {
+            for (std::size_t row = 1; row < n; ++row) {
+                T* row_ptr = b + row * ld_b;
+                for (std::size_t inner = 0; inner < row; ++inner) {
+                    kernels::axpy(col_end - col_begin, -l[row * ld_l + inner], b + inner * ld_b + col_begin,
+                                  row_ptr + col_begin);
+                }
+            }
+        });
+        return;
+    }
+
+    const std::size_t top = n / 2;
+    solve_unit_lower(l, ld_l, top, b, ld_b, n_cols, leaf, pool);
+    stats::add(stats::Counter::Flops, 2 * (n - top) * n_cols * top);
+    kernels::gemm(n - top, n_cols, top, T(-1), l + top * ld_l, ld_l, b, ld_b, T(1), b + top * ld_b, ld_b, pool);
+    solve_unit_lower(l + top * ld_l + top, ld_l, n - top, b + top * ld_b, ld_b, n_cols, leaf, pool);
+}
+
+} // namespace detail
+
+enum class LUAlgorithm {
+    // from LU<T>::kRecursiveThreshold rows on TaskGraph with several threads and Recursive with one,
+    // Blocked below
+    Auto,
+    // right-looking: a panel of block_size columns, then one update of the whole trailing matrix
+    Blocked,
+    // divide and conquer over the columns down to block_size wide leaves, cache-oblivious
+    Recursive,
+    // tiles of kTileBlocks * block_size, panel, TRSM and GEMM tiles are tasks of a dependency graph,
+    // the next panel starts while the rest of the trailing update is still running
+    TaskGraph,
+};
+
+// LU decomposition with partial pivoting: P * A = L * U.
+// Factors are kept in place: L (unit diagonal) strictly below the diagonal, U on and above it.
+// Blocked: columns are processed in panels of block_size, after each panel the trailing submatrix
+// is updated with the packed GEMM kernel, so the working set stays in cache for large matrices.
+// Recursive: the left half of the columns is factored, its U12 is solved with a recursive TRSM,
+// the right half gets one GEMM update and is factored the same way. Nearly all flops land in
+// large GEMMs and no level reads the trailing matrix once per panel, which keeps big matrices
+// off the memory bandwidth limit without tuning for a particular cache size.
+// TaskGraph: both schemes above wait for the whole trailing update after every panel, so the
+// threads idle while one of them factors the next panel. Here the update of every tile column is
+// a separate chain of tasks on a work-stealing scheduler; the critical path (the next panel and
+// the tile column it needs) is urgent, which gives lookahead without a global barrier.
+// The trailing update can run on a ThreadPool: TRSM column tiles and GEMM row blocks are split between threads,
+// pivot search stays serial, so the pivot sequence does not depend on the number of threads.
+// Factors and pivots are allocated with Alloc, an arena allocator keeps a factorization off the heap.
+template <FloatingPoint T, typename Alloc = AlignedAllocator<T>>
+class LU {
+  public:
+    static constexpr std::size_t kDefaultBlockSize = 64;
+    static constexpr std::size_t kColumnTile = detail::kColumnTile;
+    static constexpr std::size_t kRecursiveThreshold = 1536; // measured crossover, single thread, AVX2
+    static constexpr std::size_t kTileBlocks = 4;
+
+    using PivotArray = Array<std::size_t, typename std::allocator_traits<Alloc>::template rebind_alloc<std::size_t>>;
+
+    explicit LU(DenseArray<T, Alloc> matrix, std::size_t block_size = kDefaultBlockSize, std::size_t n_threads = 1,
+                LUAlgorithm algorithm = LUAlgorithm::Auto)
+        : factors_(std::move(matrix)), pivots_(factors_.n_rows(), kUninitialized, factors_.get_allocator()),
+          algorithm_(resolve(algorithm, factors_.n_rows(), n_threads))
+    {
+        assert(factors_.n_rows() == factors_.n_cols());
+        if (n_threads > 1) {
+            ThreadPool pool(n_threads);
+            factorize(std::max<std::size_t>(block_size, 1), &pool);
+        } else {
+            factorize(std::max<std::size_t>(block_size, 1), nullptr);
+        }
+    }
+
+    LU(DenseArray<T, Alloc> matrix, std::size_t block_size, ThreadPool& pool, LUAlgorithm algorithm = LUAlgorithm::Auto)
+        : factors_(std::move(matrix)), pivots_(factors_.n_rows(), kUninitialized, factors_.get_allocator()),
+          algorithm_(resolve(algorithm, factors_.n_rows(), pool.n_threads()))
+    {
+        assert(factors_.n_rows() == factors_.n_cols());
+        factorize(std::max<std::size_t>(block_size, 1), &pool);
+    }
+
+  public: // getters
+    std::size_t size() const { return factors_.n_rows(); }
+    const DenseArray<T, Alloc>& factors() const { return factors_; }
+
+    // at step i row i was swapped with row pivots()[i]
+    const PivotArray& pivots() const { return pivots_; }
+    int permutation_sign() const { return permutation_sign_; }
+
+    bool is_singular() const { return singular_; }
+
+    // the algorithm that ran, never Auto
+    LUAlgorithm algorithm() const { return algorithm_; }
+
+  public: // math
+    // overflows to inf or underflows to 0 only when the determinant itself is out of T's range
+    T determinant() const {
+        if (singular_) {
+            return T(0);
+        }
+        return scaled_determinant(diagonal_product(), permutation_sign_);
+    }
+
+    // stays finite for any size, use it when |det| may not fit into T
+    LogDeterminant<T> log_abs_determinant() const {
+        if (singular_) {
+            return {T(0), -std::numeric_limits<T>::infinity()};
+        }
+        return scaled_log_determinant(diagonal_product(), permutation_sign_);
+    }
+
+    // solves A * x = rhs reusing the factorization, O(n^2); nullopt for a singular matrix
+    std::optional<Array<T>> solve(Array<T> rhs) const {
+        assert(rhs.size() == size());
+        if (singular_) {
+            return std::nullopt;
+        }
+
+        for (std::size_t idx = 0; idx < size(); ++idx) {
+            std::swap(rhs[idx], rhs[pivots_[idx]]);
+        }
+        for (std::size_t row = 0; row < size(); ++row) {
+            const T* row_ptr = factors_.row_begin(row);
+            for (std::size_t col = 0; col < row; ++col) {
+                rhs[row] -= row_ptr[col] * rhs[col];
+            }
+        }
+        for (std::size_t row = size(); row-- > 0;) {
+            const T* row_ptr = factors_.row_begin(row);
+            for (std::size_t col = row + 1; col < size(); ++col) {
+                rhs[row] -= row_ptr[col] * rhs[col];
+            }
+            rhs[row] /= row_ptr[row];
+        }
+
+        return rhs;
+    }
+
+    // solves A * X = B for all columns of the row-major n x k view at once, X overwrites B.
+    // Substitution runs in blocks of kDefaultBlockSize rows: the contribution of already solved
+    // rows is one GEMM per block, so each right-hand side costs O(n^2) at GEMM speed.
+    // Returns false and leaves B untouched for a singular matrix
+    bool solve_inplace(MatrixView<T> rhs) const {
+        assert(rhs.n_rows() == size() && rhs.is_row_major());
+        if (singular_) {
+            return false;
+        }
+
+        const std::size_t n = size();
+        const std::size_t k = rhs.n_cols();
+        const std::size_t ld = factors_.leading_dim();
+        const std::size_t rhs_ld = rhs.row_stride();
+        auto rhs_row = [&](std::size_t row) { return rhs.data() + row * rhs_ld; };
+        if (k == 0) {
+            return true;
+        }
+
+        for (std::size_t idx = 0; idx < n; ++idx) {
+            if (pivots_[idx] != idx) {
+                std::swap_ranges(rhs_row(idx), rhs_row(idx) + k, rhs_row(pivots_[idx]));
+            }
+        }
+
+        // L * Y = P * B, L has a unit diagonal
+        for (std::size_t first = 0; first < n; first += kDefaultBlockSize) {
+            const std::size_t last = std::min(n, first + kDefaultBlockSize);
+            kernels::gemm(last - first, k, first, T(-1), factors_.row_begin(first), ld,
+                          rhs_row(0), rhs_ld, T(1), rhs_row(first), rhs_ld);
+            for (std::size_t row = first + 1; row < last; ++row) {
+                const T* row_ptr = factors_.row_begin(row);
+                for (std::size_t inner = first; inner < row; ++inner) {
+                    kernels::axpy(k, -row_ptr[inner], rhs_row(inner), rhs_row(row));
+                }
+            }
+        }
+
+        // U * X = Y, blocks from the bottom up
+        for (std::size_t last = n; last > 0;) {
+            const std::size_t first = last - std::min(last, kDefaultBlockSize);
+            kernels::gemm(last - first, k, n - last, T(-1), factors_.row_begin(first) + last, ld,
+                          rhs_row(last), rhs_ld, T(1), rhs_row(first), rhs_ld);
+            for (std::size_t row = last; row-- > first;) {
+                const T* row_ptr = factors_.row_begin(row);
+                for (std::size_t inner = row + 1; inner < last; ++inner) {
+                    kernels::axpy(k, -row_ptr[inner], rhs_row(inner), rhs_row(row));
+                }
+                kernels::scale(k, T(1) / row_ptr[row], rhs_row(row));
+            }
+            last = first;
+        }
+        return true;
+    }
+
+  private: // determinant details
+    ScaledProduct<T> diagonal_product() const {
+        stats::ScopedTimer timer(stats::Phase::Reduce);
+        ScaledProduct<T> product;
+        for (std::size_t idx = 0; idx < size(); ++idx) {
+            product.multiply(factors_.row_begin(idx)[idx]);
+        }
+        return product;
+    }
+
+  private: // factorization details
+    static constexpr std::size_t kWholeRows = static_cast<std::size_t>(-1);
+
+    static LUAlgorithm resolve(LUAlgorithm algorithm, std::size_t size, std::size_t n_threads) {
+        if (algorithm != LUAlgorithm::Auto) {
+            return algorithm;
+        }
+        if (size < kRecursiveThreshold) {
+            return LUAlgorithm::Blocked;
+        }
+        return n_threads > 1 ? LUAlgorithm::TaskGraph : LUAlgorithm::Recursive;
+    }
+
+    void factorize(const std::size_t block_size, ThreadPool* pool) {
+        stats::ScopedTimer timer(stats::Phase::Factor);
+        if (algorithm_ == LUAlgorithm::Recursive) {
+            factor_recursive(0, size(), block_size, pool);
+            return;
+        }
+        if (algorithm_ == LUAlgorithm::TaskGraph) {
+            factor_task_graph(block_size, pool);
+            return;
+        }
+
+        for (std::size_t first = 0; first < size(); first += block_size) {
+            const std::size_t width = std::min(block_size, size() - first);
+            factor_panel(first, width);
+            update_trailing(first, width, pool);
+        }
+    }
+
+    // unblocked elimination of columns [first, first + width), touching only those columns;
+    // row swaps cover the columns [swap_begin, swap_end), whole rows by default
+    void factor_panel(const std::size_t first, const std::size_t width, const std::size_t swap_begin = 0,
+                      const std::size_t swap_end = kWholeRows) {
+        const detail::PanelPivoting pivoting = detail::factor_panel(
+            factors_.row_begin(first) + first, factors_.leading_dim(), size() - first, width, first, pivots_.begin() + first,
+            [&](std::size_t row, std::size_t other) { swap_rows(row, other, swap_begin, std::min(swap_end, size())); });
+        permutation_sign_ *= pivoting.sign;
+        singular_ = singular_ || pivoting.singular;
+    }
+
+    // U12 = L11^-1 * A12, then A22 -= L21 * U12
+    void update_trailing(const std::size_t first, const std::size_t width, ThreadPool* pool) {
+        const std::size_t last = first + width;
+        if (last >= size()) {
+            return;
+        }
+        const std::size_t n_trailing = size() - last;
+
+        solve_lower_leaf(first, width, last, n_trailing, pool);
+        update_schur(last, first, width, last, n_trailing, pool);
+    }
+
+    // B = L^-1 * B, L is the unit lower triangle of rows and columns [first, first + width) and
+    // B the rows [first, first + width) of columns [col, col + n_cols); B columns are independent
+    void solve_lower_leaf(const std::size_t first, const std::size_t width, const std::size_t col,
+                          const std::size_t n_cols, ThreadPool* pool) {
+        solve_lower(first, width, col, n_cols, width, pool);
+    }
+
+    // rows [row, size()) of columns [col, col + n_cols) -= L(rows, [inner, inner + width)) * U([inner, inner + width), cols)
+    void update_schur(const std::size_t row, const std::size_t inner, const std::size_t width,
+                      const std::size_t col, const std::size_t n_cols, ThreadPool* pool) {
+        update_tile(row, size() - row, inner, width, col, n_cols, pool);
+    }
+
+    // the same for the rows [row, row + n_rows) only
+    void update_tile(const std::size_t row, const std::size_t n_rows, const std::size_t inner, const std::size_t width,
+                     const std::size_t col, const std::size_t n_cols, ThreadPool* pool) {
+        const std::size_t ld = factors_.leading_dim();
+        stats::add(stats::Counter::Flops, 2 * n_rows * n_cols * width);
+        kernels::gemm(n_rows, n_cols, width, T(-1), factors_.row_begin(row) + inner, ld,
+                      factors_.row_begin(inner) + col, ld, T(1), factors_.row_begin(row) + col, ld, pool);
+    }
+
+    // columns [first, first + width) of rows [first, size()), every row swap moves whole rows
+    // (or the columns [swap_begin, swap_end)), so the already factored columns on the left and
+    // the pending ones on the right follow it
+    void factor_recursive(const std::size_t first, const std::size_t width, const std::size_t leaf, ThreadPool* pool,
+                          const std::size_t swap_begin = 0, const std::size_t swap_end = kWholeRows) {
+        if (width <= leaf) {
+            factor_panel(first, width, swap_begin, swap_end);
+            return;
+        }
+
+        const std::size_t left = width / 2;
+        const std::size_t mid = first + left;
+        factor_recursive(first, left, leaf, pool, swap_begin, swap_end);
+        solve_lower(first, left, mid, width - left, leaf, pool);
+        update_schur(mid, first, left, mid, width - left, pool);
+        factor_recursive(mid, width - left, leaf, pool, swap_begin, swap_end);
+    }
+
+    // the same with recursive halving down to blocks of leaf rows
+    void solve_lower(const std::size_t first, const std::size_t width, const std::size_t col,
+                     const std::size_t n_cols, const std::size_t leaf, ThreadPool* pool) {
+        const std::size_t ld = factors_.leading_dim();
+        detail::solve_unit_lower(factors_.row_begin(first) + first, ld, width, factors_.row_begin(first) + col, ld,
+                                 n_cols, leaf, pool);
+    }
+
+    void swap_rows(const std::size_t first_row, const std::size_t second_row, const std::size_t col_begin,
+                   const std::size_t col_end) {
+        std::swap_ranges(factors_.row_begin(first_row) + col_begin, factors_.row_begin(first_row) + col_end,
+                         factors_.row_begin(second_row) + col_begin);
+    }
+
+    // Tile t covers the rows and columns [t * tile, (t + 1) * tile). Step k runs
+    //   panel(k):        factors the tile column k below the diagonal, swapping inside that column only;
+    //   trsm(k, j):      j > k, applies the swaps of panel(k) to tile column j and solves its U tile;
+    //   gemm(k, i, j):   i, j > k, A(i, j) -= L(i, k) * U(k, j).
+    // The next step on tile column j (panel(k + 1) or trsm(k + 1, j)) waits for every gemm(k, *, j)
+    // and, for trsm, for panel(k + 1); ready[k][j] counts what is still missing.
+    // Swaps of panel(k) in the columns left of it would race with the gemms still reading those
+    // L tiles, they are applied once at the end.
+    void factor_task_graph(const std::size_t block_size, ThreadPool* pool) {
+        const std::size_t n = size();
+        const std::size_t tile = block_size * kTileBlocks;
+        const std::size_t n_tiles = (n + tile - 1) / tile;
+        if (n_tiles <= 1) {
+            factor_recursive(0, n, block_size, pool);
+            return;
+        }
+        auto begin = [&](std::size_t t) { return t * tile; };
+        auto width = [&](std::size_t t) { return std::min(tile, n - t * tile); };
+
+        // ready[k * n_tiles + j]: gemm(k - 1, *, j) for the tile rows k..n_tiles-1, plus panel(k) for trsm
+        auto ready = std::make_unique<std::atomic<std::size_t>[]>(n_tiles * n_tiles);
+        for (std::size_t k = 0; k < n_tiles; ++k) {
+            for (std::size_t j = k; j < n_tiles; ++j) {
+                ready[k * n_tiles + j].store((k > 0 ? n_tiles - k : 0) + (j > k ? 1 : 0), std::memory_order_relaxed);
+            }
+        }
+
+        TaskScheduler scheduler(pool == nullptr ? 1 : pool->n_threads());
+        // the panels and tile column k + 1 form the critical path
+        auto urgent = [](std::size_t k, std::size_t j) { return j == k + 1; };
+        std::function<void(std::size_t, std::size_t)> arrive;
+
+        auto gemm_task = [&](std::size_t k, std::size_t i, std::size_t j) {
+            update_tile(begin(i), width(i), begin(k), width(k), begin(j), width(j), nullptr);
+            arrive(k + 1, j);
+        };
+        auto trsm_task = [&](std::size_t k, std::size_t j) {
+            for (std::size_t row = begin(k); row < begin(k) + width(k); ++row) {
+                if (pivots_[row] != row) {
+                    swap_rows(row, pivots_[row], begin(j), begin(j) + width(j));
+                }
+            }
+            solve_lower(begin(k), width(k), begin(j), width(j), block_size, nullptr);
+            for (std::size_t i = k + 1; i < n_tiles; ++i) {
+                scheduler.spawn([&, k, i, j] { gemm_task(k, i, j); }, urgent(k, j));
+            }
+        };
+        auto panel_task = [&](std::size_t k) {
+            factor_recursive(begin(k), width(k), block_size, nullptr, begin(k), begin(k) + width(k));
+            for (std::size_t j = k + 1; j < n_tiles; ++j) {
+                arrive(k, j);
+            }
+        };
+        // one more dependency of the next task on tile column j at step k is met
+        arrive = [&](std::size_t k, std::size_t j) {
+            if (ready[k * n_tiles + j].fetch_sub(1, std::memory_order_acq_rel) != 1) {
+                return;
+            }
+            if (j == k) {
+                scheduler.spawn([&, k] { panel_task(k); }, true);
+            } else {
+                scheduler.spawn([&, k, j] { trsm_task(k, j); }, urgent(k, j));
+            }
+        };
+
+        scheduler.spawn([&] { panel_task(0); }, true);
+        scheduler.run(pool);
+
+        detail::for_range(pool, 0, begin(n_tiles - 1), kColumnTile, [&](std::size_t col_begin, std::size_t col_end) {
+            for (std::size_t row = 0; row < n; ++row) {
+                const std::size_t panel_begin = row / tile * tile;
+                if (pivots_[row] != row && col_begin < panel_begin) {
+                    swap_rows(row, pivots_[row], col_begin, std::min(col_end, panel_begin));
+                }
+            }
+        });
+    }
+
+  private: // fields
+    DenseArray<T, Alloc> factors_{};
+    PivotArray pivots_{};
+    LUAlgorithm algorithm_ = LUAlgorithm::Blocked;
+    int permutation_sign_ = 1;
+    bool singular_ = false;
+};
+
+} // namespace mtx
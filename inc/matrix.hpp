@@ -3,144 +3,283 @@
 #include <cassert>
 #include <cmath>
 #include <algorithm>
+#include <optional>
 
 #include "common.hpp"
-#include "jagged_array.hpp"
+#include "allocators.hpp"
+#include "dense_array.hpp"
+#include "exact_determinant.hpp"
+#include "expression.hpp"
+#include "gemm.hpp"
+#include "lu.hpp"
+#include "matrix_view.hpp"
+#include "stats.hpp"
+#include "transpose.hpp"
 
 namespace mtx {
 
-template <FloatingPoint T>
+// Alloc provides the element storage: AlignedAllocator by default,
+// ArenaAllocator for scratch matrices created and dropped in a hot loop.
+// T may be any Ring; LU, solves and the inverse are only available for floating point T,
+// determinants of other types are exact (see exact_determinant.hpp)
+template <Ring T, typename Alloc = AlignedAllocator<T>>
 class Matrix {
   public: // constructors    
-    explicit Matrix(const std::size_t size) : data_(size, size) {}
+    using allocator_type = Alloc;
 
-    Matrix(const std::size_t n_rows, const std::size_t n_cols) : data_(n_rows, n_cols) {}
+    explicit Matrix(const std::size_t size, const Alloc& alloc = Alloc()) : data_(size, size, T{}, alloc) {}
+
+    Matrix(const std::size_t n_rows, const std::size_t n_cols, const Alloc& alloc = Alloc())
+        : data_(n_rows, n_cols, T{}, alloc) {}
+
+    // elements are left unset and must be written before they are read
+    Matrix(const std::size_t n_rows, const std::size_t n_cols, Uninitialized, const Alloc& alloc = Alloc())
+        : data_(n_rows, n_cols, kUninitialized, alloc) {}
 
     template<typename Iter>
     requires IteratorOf<Iter, T>
-    Matrix(const std::size_t n_rows, const std::size_t n_cols, Iter elems_begin, Iter elems_end) 
-        : data_(n_rows, n_cols, elems_begin, elems_end) {}
+    Matrix(const std::size_t n_rows, const std::size_t n_cols, Iter elems_begin, Iter elems_end, const Alloc& alloc = Alloc()) 
+        : data_(n_rows, n_cols, elems_begin, elems_end, alloc) {}
+
+    Matrix(std::initializer_list<std::initializer_list<T>> init_lists, const Alloc& alloc = Alloc())
+        : data_(init_lists, alloc) {}
+
+    // copies the viewed elements
+    template <typename U>
+    requires std::same_as<std::remove_const_t<U>, T>
+    explicit Matrix(MatrixView<U> view, const Alloc& alloc = Alloc())
+        : data_(view.n_rows(), view.n_cols(), kUninitialized, alloc)
+    {
+        if (view.is_row_major()) {
+            for (std::size_t row = 0; row < n_rows(); ++row) {
+                std::copy_n(view[row].begin(), n_cols(), data_.row_begin(row));
+            }
+        } else {
+            this->view().assign(view);
+        }
+    }
+
+    // evaluates a lazy element-wise expression such as a + b * s - c in a single pass
+    template <ExpressionOf<ExprShape::Matrix> E>
+    requires std::derived_from<E, ExprNode> && std::same_as<expr_value_t<E>, T>
+    Matrix(const E& expr, const Alloc& alloc = Alloc())
+        : data_(ExprTraits<E>::n_rows(expr), ExprTraits<E>::n_cols(expr), kUninitialized, alloc) {
+        assign(expr);
+    }
+
+    // the expression may reference this matrix, elements are only overwritten at their own position
+    template <ExpressionOf<ExprShape::Matrix> E>
+    requires std::derived_from<E, ExprNode> && std::same_as<expr_value_t<E>, T>
+    Matrix& operator=(const E& expr) {
+        if (ExprTraits<E>::n_rows(expr) != n_rows() || ExprTraits<E>::n_cols(expr) != n_cols()) {
+            *this = Matrix(expr, data_.get_allocator());
+        } else {
+            assign(expr);
+        }
 
-    Matrix(std::initializer_list<std::initializer_list<T>> init_lists)
-        : data_(init_lists) {}
+        return *this;
+    }
 
-    static Matrix<T> diag(const std::size_t size, const T value) {
-        Matrix<T> diag_matrix(size, size);
+    static Matrix diag(const std::size_t size, const T value, const Alloc& alloc = Alloc()) {
+        Matrix diag_matrix(size, size, alloc);
         for (std::size_t i = 0; i < size; i++)
             diag_matrix[i][i] = value;
         
         return diag_matrix;
     }
 
-    static Matrix<T> identity(const std::size_t size) {
-        return diag(size, T(1.0));
+    static Matrix identity(const std::size_t size, const Alloc& alloc = Alloc()) {
+        return diag(size, T(1), alloc);
     }
 
   public: // getters
     std::size_t n_rows() const { return data_.n_rows(); }
     std::size_t n_cols() const { return data_.n_cols(); } 
-    const RectangularArray<T>& data() const { return data_; }
+    DenseArray<T, Alloc>& data() { return data_; }
+    const DenseArray<T, Alloc>& data() const { return data_; }
+    Alloc get_allocator() const { return data_.get_allocator(); }
 
   public: // operators
-    Array<T>& operator[](const std::size_t idx) {
+    RowView<T> operator[](const std::size_t idx) {
         return data_[idx];
     }
 
-    const Array<T>& operator[](const std::size_t idx) const {
+    RowView<const T> operator[](const std::size_t idx) const {
         return data_[idx];
     }
 
+  public: // views, valid until the matrix is resized or destroyed
+    MatrixView<T> view() { return MatrixView<T>(data_.data(), n_rows(), n_cols(), data_.leading_dim()); }
+    ConstMatrixView<T> view() const { return ConstMatrixView<T>(data_.data(), n_rows(), n_cols(), data_.leading_dim()); }
+
+    MatrixView<T> block(std::size_t first_row, std::size_t first_col, std::size_t n_rows, std::size_t n_cols) {
+        return view().block(first_row, first_col, n_rows, n_cols);
+    }
+    ConstMatrixView<T> block(std::size_t first_row, std::size_t first_col, std::size_t n_rows, std::size_t n_cols) const {
+        return view().block(first_row, first_col, n_rows, n_cols);
+    }
+
+    MatrixView<T> row(std::size_t idx) { return view().row(idx); }
+    ConstMatrixView<T> row(std::size_t idx) const { return view().row(idx); }
+
+    MatrixView<T> col(std::size_t idx) { return view().col(idx); }
+    ConstMatrixView<T> col(std::size_t idx) const { return view().col(idx); }
+
+    // A^T without moving any data, transpose() makes a row-major copy
+    MatrixView<T> transposed_view() { return view().transposed(); }
+    ConstMatrixView<T> transposed_view() const { return view().transposed(); }
+
   public: // math
-    Matrix<T>& negate() {
+    Matrix& negate() {
         for (std::size_t i = 0; i < n_rows(); i++) {
             for (std::size_t j = 0; j < n_cols(); j++) {
-                data_[i][j] *= T(-1.0);
+                data_[i][j] = -data_[i][j];
             }
         }
 
         return *this;
     }
 
+    // adding rows with n_cols() unchanged is amortized O(1) per row, see DenseArray::resize
     void resize(std::size_t new_n_cols, std::size_t new_n_rows) {
-        data_.resize(new_n_rows);
-        data_.resize_rows(new_n_cols);
+        data_.resize(new_n_rows, new_n_cols);
     }
 
-    Matrix<T> transpose() const {
-        Matrix<T> res_matrix(n_cols(), n_rows());
-        for (std::size_t i = 0; i < n_rows(); i++) {
-            for (std::size_t j = 0; j < n_cols(); j++) {
-                res_matrix[j][i] = data_[i][j];
-            }
-        }
+    void reserve_rows(std::size_t n_rows) {
+        data_.reserve_rows(n_rows);
+    }
+
+    Matrix transpose() const {
+        Matrix res_matrix(n_cols(), n_rows(), kUninitialized, data_.get_allocator());
+        mtx::transpose(view(), res_matrix.view());
 
         return res_matrix;
-    };
+    }
+
+    // square matrices only, no extra memory is allocated
+    Matrix& transpose_inplace() {
+        assert(n_rows() == n_cols());
+        kernels::transpose_inplace(n_rows(), data_.data(), data_.leading_dim());
+
+        return *this;
+    }
 
     void swap_rows(const std::size_t fst_idx, const std::size_t snd_idx) {
         data_.swap_rows(fst_idx, snd_idx);
     }
     
-    T determinant() const {
-        bool flag_sign = 0;
-        Matrix cur_matrix(*this);
-        for (std::size_t row_idx = 0; row_idx < n_rows() - 1; ++row_idx) {
-            std::size_t row_idx_max_value = cur_matrix.get_row_max_value(row_idx, row_idx);
-            if (FloatingPointE<T>(cur_matrix.data_[row_idx_max_value][row_idx], T(0))) {
-                return 0;
-            }
-            if (row_idx_max_value != row_idx) {
-                flag_sign = !flag_sign;
-                cur_matrix.swap_rows(row_idx_max_value, row_idx);
-            }
-            for (std::size_t row_idx_2 = row_idx + 1; row_idx_2 < n_rows(); ++row_idx_2) {
-                cur_matrix.add_row_to_row(row_idx_2, row_idx, -cur_matrix.data_[row_idx_2][row_idx] / cur_matrix.data_[row_idx][row_idx]);
-            }
-        }
-        T res = 1;
-        for (std::size_t index = 0; index < n_rows(); ++index) {
-            res *= cur_matrix.data_[index][index];
-        }
+    // factorization of a copy of the matrix, reuse it to ask several questions about the same matrix
+    auto lu(const std::size_t block_size = kLUBlockSize, const std::size_t n_threads = 1,
+            const LUAlgorithm algorithm = LUAlgorithm::Auto) const& requires FloatingPoint<T> {
+        DenseArray<T, Alloc> factors = [this] {
+            stats::ScopedTimer timer(stats::Phase::Copy);
+            return data_;
+        }();
+        return LU<T, Alloc>(std::move(factors), block_size, n_threads, algorithm);
+    }
 
-        if (flag_sign && !FloatingPointE<T>(res, 0)) {
-            return -res;
-        }
-        return res;
+    // factors the matrix's own storage instead of a copy, the matrix is left empty
+    auto lu(const std::size_t block_size = kLUBlockSize, const std::size_t n_threads = 1,
+            const LUAlgorithm algorithm = LUAlgorithm::Auto) && requires FloatingPoint<T> {
+        return LU<T, Alloc>(std::move(data_), block_size, n_threads, algorithm);
     }
 
-  private: // determinant details
-    // find row with max abs elem in column
-    std::size_t get_row_max_value(const std::size_t column, const std::size_t start_row) const {
-        assert(column < n_cols());
+    // LU for floating point, the multi-modular method for integers, Bareiss elimination for other rings
+    T determinant(const std::size_t n_threads = 1) const {
+        if constexpr (FloatingPoint<T>) {
+            return lu(kLUBlockSize, n_threads).determinant();
+        } else if constexpr (std::integral<T>) {
+            assert(n_rows() == n_cols());
+            return modular_determinant<T>(view(), n_threads);
+        } else {
+            return bareiss_determinant(data_);
+        }
+    }
 
-        std::size_t result_row_idx = start_row;
-        T result_value = std::fabs(data_[start_row][column]);
+    auto log_abs_determinant(const std::size_t n_threads = 1) const requires FloatingPoint<T> {
+        return lu(kLUBlockSize, n_threads).log_abs_determinant();
+    }
 
-        for (std::size_t row_idx = start_row + 1; row_idx < n_rows(); ++row_idx) {
-            T cur_val = std::fabs(data_[row_idx][column]);
-            
-            if (cur_val > result_value) {
-                result_value = cur_val;
-                result_row_idx = row_idx;
-            }
+    // A^-1 from one factorization and a blocked solve against the identity, nullopt for a singular matrix
+    std::optional<Matrix> inverse(const std::size_t n_threads = 1) const requires FloatingPoint<T> {
+        assert(n_rows() == n_cols());
+        Matrix res_matrix = identity(n_rows(), data_.get_allocator());
+        if (!lu(kLUBlockSize, n_threads).solve_inplace(res_matrix.view())) {
+            return std::nullopt;
         }
-    
-        return result_row_idx;
+
+        return res_matrix;
     }
 
-    void add_row_to_row(const std::size_t dst_row_idx, const std::size_t src_row_idx, const T& mul = T(1.0)) {
-        assert(dst_row_idx < n_rows());
-        assert(src_row_idx < n_rows());
-    
-        data_[dst_row_idx] += data_[src_row_idx] * mul;
+  private:
+    // LU<T> cannot be named for non-floating T
+    static constexpr std::size_t kLUBlockSize = LU<double>::kDefaultBlockSize;
+
+    template <typename E>
+    void assign(const E& expr) {
+        for (std::size_t row = 0; row < n_rows(); ++row) {
+            assign_row(row, n_cols(), data_.row_begin(row), expr);
+        }
     }
 
   private: // fields
-    RectangularArray<T> data_{};
+    DenseArray<T, Alloc> data_{};
 };
 
-template<FloatingPoint T>
-std::ostream& operator<<(std::ostream& ostream, const Matrix<T>& matrix) {
+// A + B, A - B and A * s are lazy, see expression.hpp; A * B stays the matrix product
+template <Ring T, typename Alloc>
+struct ExprTraits<Matrix<T, Alloc>> {
+    using value_type = T;
+    static constexpr ExprShape kShape = ExprShape::Matrix;
+
+    static std::size_t n_rows(const Matrix<T, Alloc>& matrix) { return matrix.n_rows(); }
+    static std::size_t n_cols(const Matrix<T, Alloc>& matrix) { return matrix.n_cols(); }
+    static const T& at(const Matrix<T, Alloc>& matrix, std::size_t row, std::size_t col) {
+        return matrix.data().row_begin(row)[col];
+    }
+};
+
+template<Ring T, typename Alloc>
+void gemm(const T alpha, const Matrix<T, Alloc>& a, const Matrix<T, Alloc>& b, const T beta, Matrix<T, Alloc>& c,
+          const std::size_t n_threads = 1) {
+    gemm(alpha, a.view(), b.view(), beta, c.view(), n_threads);
+}
+
+// the elimination needs a private copy of the viewed elements
+template<typename TV>
+requires Ring<std::remove_const_t<TV>>
+std::remove_const_t<TV> determinant(MatrixView<TV> view, const std::size_t n_threads = 1) {
+    using T = std::remove_const_t<TV>;
+    assert(view.n_rows() == view.n_cols());
+    return Matrix<T>(view).determinant(n_threads);
+}
+
+// x with A * x = b, nullopt for a singular A; to solve against the same A many times, keep a.lu()
+// and call solve on it
+template<FloatingPoint T, typename Alloc>
+std::optional<Array<T>> solve(const Matrix<T, Alloc>& a, Array<T> b) {
+    return a.lu().solve(std::move(b));
+}
+
+// X with A * X = B for every column of B at once, nullopt for a singular A
+template<FloatingPoint T, typename Alloc>
+std::optional<Matrix<T, Alloc>> solve(const Matrix<T, Alloc>& a, Matrix<T, Alloc> b) {
+    if (!a.lu().solve_inplace(b.view())) {
+        return std::nullopt;
+    }
+    return b;
+}
+
+template<Ring T, typename Alloc>
+Matrix<T, Alloc> operator*(const Matrix<T, Alloc>& a, const Matrix<T, Alloc>& b) {
+    // beta == 0 overwrites the result, so it is not zeroed first
+    Matrix<T, Alloc> res_matrix(a.n_rows(), b.n_cols(), kUninitialized, a.get_allocator());
+    gemm(T(1), a, b, T(0), res_matrix);
+    return res_matrix;
+}
+
+template<Ring T, typename Alloc>
+std::ostream& operator<<(std::ostream& ostream, const Matrix<T, Alloc>& matrix) {
     ostream << matrix.data();
 
     return ostream;
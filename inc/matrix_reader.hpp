@@ -0,0 +1,145 @@
+#pragma once
+
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <istream>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+namespace mtx {
+
+// Reads whitespace-separated numbers from a stream in large chunks and parses them
+// with std::from_chars straight from the buffer, without per-token strings or streams.
+// Recovery matches scan_until_next_line from common.hpp: a token that is not entirely
+// a number makes the reader skip the rest of its line.
+class MatrixReader {
+  public:
+    static constexpr std::size_t kDefaultChunkSize = 1 << 20;
+
+    explicit MatrixReader(std::istream& stream, std::size_t chunk_size = kDefaultChunkSize)
+        : stream_(stream), buffer_(std::max<std::size_t>(chunk_size, 2)) {}
+
+  public:
+    template <typename T>
+    bool scan_until_next_line(T& val) {
+        while (true) {
+            std::string_view token;
+            if (!next_token(token)) {
+                return false;
+            }
+
+            if (parse_token(token, val)) {
+                return true;
+            }
+            skip_line();
+        }
+    }
+
+    // fills dst with up to count values, returns how many were read
+    template <typename T>
+    std::size_t read_values(T* dst, std::size_t count) {
+        for (std::size_t idx = 0; idx < count; ++idx) {
+            if (!scan_until_next_line(dst[idx])) {
+                return idx;
+            }
+        }
+        return count;
+    }
+
+  private:
+    static bool is_space(char symbol) {
+        return symbol == ' ' || symbol == '\n' || symbol == '\t' || symbol == '\r' || symbol == '\v' || symbol == '\f';
+    }
+
+    template <typename T>
+    static bool parse_token(std::string_view token, T& val) {
+        const char* first = token.data();
+        const char* last = token.data() + token.size();
+        // operator>> accepts an explicit plus sign, from_chars does not
+        if (last - first > 1 && first[0] == '+' && first[1] != '-') {
+            ++first;
+        }
+
+        auto [ptr, error] = std::from_chars(first, last, val);
+        return error == std::errc() && ptr == last;
+    }
+
+    // drops everything before keep_from and appends the next chunk, false if the stream is exhausted
+    bool refill(std::size_t keep_from) {
+        if (keep_from > 0) {
+            std::copy(buffer_.begin() + keep_from, buffer_.begin() + end_, buffer_.begin());
+            end_ -= keep_from;
+            pos_ -= keep_from;
+        }
+        if (end_ == buffer_.size()) {
+            buffer_.resize(buffer_.size() * 2);
+        }
+
+        const std::streamsize n_read = stream_.rdbuf()->sgetn(buffer_.data() + end_, buffer_.size() - end_);
+        if (n_read <= 0) {
+            return false;
+        }
+        end_ += static_cast<std::size_t>(n_read);
+        return true;
+    }
+
+    // the token stays valid until the next call
+    bool next_token(std::string_view& token) {
+        while (true) {
+            while (pos_ < end_ && is_space(buffer_[pos_])) {
+                ++pos_;
+            }
+            if (pos_ < end_) {
+                break;
+            }
+            if (!refill(pos_)) {
+                return false;
+            }
+        }
+
+        std::size_t token_end = pos_;
+        while (true) {
+            while (token_end < end_ && !is_space(buffer_[token_end])) {
+                ++token_end;
+            }
+            if (token_end < end_) {
+                break;
+            }
+
+            const std::size_t token_length = token_end - pos_;
+            const bool refilled = refill(pos_);
+            token_end = pos_ + token_length;
+            if (!refilled) {
+                break;
+            }
+        }
+
+        token = std::string_view(buffer_.data() + pos_, token_end - pos_);
+        pos_ = token_end;
+        return true;
+    }
+
+    // skip until next line or EOF
+    void skip_line() {
+        while (true) {
+            while (pos_ < end_) {
+                if (buffer_[pos_++] == '\n') {
+                    return;
+                }
+            }
+            if (!refill(pos_)) {
+                return;
+            }
+        }
+    }
+
+  private:
+    std::istream& stream_;
+    std::vector<char> buffer_{};
+    std::size_t pos_ = 0;
+    std::size_t end_ = 0;
+};
+
+} // namespace mtx
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <type_traits>
+
+#include "common.hpp"
+#include "dense_array.hpp"
+#include "expression.hpp"
+#include "gemm.hpp"
+#include "thread_pool.hpp"
+#include "transpose.hpp"
+
+namespace mtx {
+
+// Non-owning view of an n_rows x n_cols part of a matrix, element (i, j) is data[i * row_stride + j * col_stride].
+// T may be const-qualified. Sub-views (blocks, rows, columns, the transpose) only change
+// the offset, sizes and strides, so taking them never copies or allocates.
+template <typename T>
+class MatrixView {
+  public:
+    MatrixView() = default;
+
+    MatrixView(T* data, std::size_t n_rows, std::size_t n_cols, std::size_t row_stride, std::size_t col_stride = 1)
+        : data_(data), n_rows_(n_rows), n_cols_(n_cols), row_stride_(row_stride), col_stride_(col_stride) {}
+
+    operator MatrixView<const T>() const requires (!std::is_const_v<T>) {
+        return MatrixView<const T>(data_, n_rows_, n_cols_, row_stride_, col_stride_);
+    }
+
+  public: // getters
+    std::size_t n_rows() const { return n_rows_; }
+    std::size_t n_cols() const { return n_cols_; }
+    std::size_t row_stride() const { return row_stride_; }
+    std::size_t col_stride() const { return col_stride_; }
+
+    bool empty() const { return n_rows_ == 0 || n_cols_ == 0; }
+
+    // rows are contiguous, so they can be handed to the row-major kernels with leading dimension row_stride()
+    bool is_row_major() const { return col_stride_ == 1; }
+
+    T* data() const { return data_; }
+
+  public: // operators
+    T& operator()(std::size_t row, std::size_t col) const {
+        assert(row < n_rows_ && col < n_cols_);
+        return data_[row * row_stride_ + col * col_stride_];
+    }
+
+    RowView<T> operator[](std::size_t idx) const {
+        assert(idx < n_rows_ && is_row_major());
+        return RowView<T>(data_ + idx * row_stride_, n_cols_);
+    }
+
+  public: // sub-views
+    MatrixView block(std::size_t first_row, std::size_t first_col, std::size_t n_rows, std::size_t n_cols) const {
+        assert(first_row + n_rows <= n_rows_ && first_col + n_cols <= n_cols_);
+        return MatrixView(data_ + first_row * row_stride_ + first_col * col_stride_, n_rows, n_cols,
+                          row_stride_, col_stride_);
+    }
+
+    MatrixView row(std::size_t idx) const { return block(idx, 0, 1, n_cols_); }
+
+    MatrixView col(std::size_t idx) const { return block(0, idx, n_rows_, 1); }
+
+    MatrixView transposed() const { return MatrixView(data_, n_cols_, n_rows_, col_stride_, row_stride_); }
+
+  public:
+    void fill(const std::remove_const_t<T>& value) const requires (!std::is_const_v<T>) {
+        for (std::size_t row = 0; row < n_rows_; ++row) {
+            for (std::size_t col = 0; col < n_cols_; ++col) {
+                (*this)(row, col) = value;
+            }
+        }
+    }
+
+    // writes a matrix-shaped expression (a view, a Matrix or a lazy a + b * s) into the viewed elements;
+    // the expression may read the destination only at the position being written
+    template <ExpressionOf<ExprShape::Matrix> E>
+    requires (!std::is_const_v<T>)
+    void assign(const E& expr) const {
+        assert(ExprTraits<E>::n_rows(expr) == n_rows_ && ExprTraits<E>::n_cols(expr) == n_cols_);
+        for (std::size_t row = 0; row < n_rows_; ++row) {
+            for (std::size_t col = 0; col < n_cols_; ++col) {
+                (*this)(row, col) = ExprTraits<E>::at(expr, row, col);
+            }
+        }
+    }
+
+  private:
+    T* data_ = nullptr;
+    std::size_t n_rows_ = 0;
+    std::size_t n_cols_ = 0;
+    std::size_t row_stride_ = 0;
+    std::size_t col_stride_ = 1;
+};
+
+template <typename T>
+using ConstMatrixView = MatrixView<const T>;
+
+template <typename T>
+inline constexpr bool kExprByValue<MatrixView<T>> = true;
+
+template <typename T>
+struct ExprTraits<MatrixView<T>> {
+    using value_type = std::remove_const_t<T>;
+    static constexpr ExprShape kShape = ExprShape::Matrix;
+
+    static std::size_t n_rows(const MatrixView<T>& view) { return view.n_rows(); }
+    static std::size_t n_cols(const MatrixView<T>& view) { return view.n_cols(); }
+    static const value_type& at(const MatrixView<T>& view, std::size_t row, std::size_t col) { return view(row, col); }
+};
+
+// C = alpha * A * B + beta * C on views of any strides (a transposed view is packed in place),
+// C must be row-major, already have A.n_rows() x B.n_cols() shape and must not alias A or B
+template<typename TA, typename TB, Ring T>
+requires std::same_as<std::remove_const_t<TA>, T> && std::same_as<std::remove_const_t<TB>, T>
+void gemm(const T alpha, MatrixView<TA> a, MatrixView<TB> b, const T beta, MatrixView<T> c, const std::size_t n_threads = 1) {
+    assert(a.n_cols() == b.n_rows());
+    assert(c.n_rows() == a.n_rows() && c.n_cols() == b.n_cols());
+    assert(c.is_row_major());
+
+    auto run = [&](ThreadPool* pool) {
+        kernels::gemm(a.n_rows(), b.n_cols(), a.n_cols(), alpha, a.data(), a.row_stride(), a.col_stride(),
+                      b.data(), b.row_stride(), b.col_stride(), beta, c.data(), c.row_stride(), pool);
+    };
+
+    if (n_threads > 1) {
+        ThreadPool pool(n_threads);
+        run(&pool);
+    } else {
+        run(nullptr);
+    }
+}
+
+// dst = src^T, dst must have src.n_cols() x src.n_rows() shape and must not overlap src
+template<typename TS, typename T>
+requires std::same_as<std::remove_const_t<TS>, T>
+void transpose(MatrixView<TS> src, MatrixView<T> dst) {
+    assert(dst.n_rows() == src.n_cols() && dst.n_cols() == src.n_rows());
+    if (src.is_row_major() && dst.is_row_major()) {
+        kernels::transpose(src.n_rows(), src.n_cols(), src.data(), src.row_stride(), dst.data(), dst.row_stride());
+    } else {
+        dst.assign(src.transposed());
+    }
+}
+
+} // namespace mtx
@@ -0,0 +1,199 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <numbers>
+#include <optional>
+#include <vector>
+
+#include "common.hpp"
+#include "dense_array.hpp"
+#include "gemm.hpp"
+#include "jagged_array.hpp"
+#include "lu.hpp"
+#include "matrix.hpp"
+#include "matrix_view.hpp"
+#include "stats.hpp"
+
+namespace mtx {
+
+// Mixed-precision LU: the O(n^3) factorization runs in Low (float: twice the SIMD lanes and half
+// the memory traffic of double), everything O(n^2) runs in T:
+//  - every row is scaled by a power of two before rounding to Low, so the rounding is the only
+//    error and values outside Low's range stay representable; the scaling is exact and is undone in T;
+//  - the determinant is the product of the Low pivots accumulated and renormalized in T,
+//    its accuracy is that of the Low factorization, not of the Low running product;
+//  - solve() refines x in T (residual b - A * x in T, correction with the Low factors) until the
+//    residual is at T's rounding level, as LAPACK's dsgesv does;
+//  - the scaled rows have their largest element in [0.5, 1), so a pivot below sqrt(epsilon of Low)
+//    means the elimination cancelled most of its row: Low keeps too few digits of such a matrix.
+//    Then, and for an exact zero Low pivot, determinant() and solve() use a factorization in T;
+//    solve() also falls back to it when the refinement does not converge.
+// The original matrix is only viewed, it must outlive the factorization.
+template <FloatingPoint T = double, FloatingPoint Low = float>
+class MixedPrecisionLU {
+  public:
+    static constexpr std::size_t kMaxRefinements = 30;
+
+    explicit MixedPrecisionLU(ConstMatrixView<T> matrix, std::size_t block_size = LU<Low>::kDefaultBlockSize,
+                              std::size_t n_threads = 1)
+        : matrix_(matrix), block_size_(block_size), n_threads_(n_threads),
+          row_exponents_(row_exponents(matrix)), lu_(to_low(matrix, row_exponents_), block_size, n_threads),
+          needs_high_precision_(lu_.is_singular() || has_cancelled_pivot(lu_)) {}
+
+  public: // getters
+    std::size_t size() const { return lu_.size(); }
+    const LU<Low>& low_precision_lu() const { return lu_; }
+
+    // singular or too ill-conditioned for Low, the answers then come from a factorization in T
+    bool needs_high_precision() const { return needs_high_precision_; }
+
+  public: // math
+    T determinant() const {
+        if (needs_high_precision()) {
+            return high_precision_lu().determinant();
+        }
+        return scaled_determinant(diagonal_product(), lu_.permutation_sign());
+    }
+
+    LogDeterminant<T> log_abs_determinant() const {
+        if (needs_high_precision()) {
+            return high_precision_lu().log_abs_determinant();
+        }
+        return scaled_log_determinant(diagonal_product(), lu_.permutation_sign());
+    }
+
+    // x with A * x = rhs to the accuracy of T, nullopt for a singular matrix
+    std::optional<Array<T>> solve(const Array<T>& rhs, std::size_t max_refinements = kMaxRefinements) const {
+        assert(rhs.size() == size());
+        if (needs_high_precision()) {
+            return high_precision_lu().solve(rhs);
+        }
+
+        const std::size_t n = size();
+        const T a_norm = inf_norm();
+        const T tolerance = std::sqrt(T(n)) * std::numeric_limits<T>::epsilon() * a_norm;
+
+        Array<T> x(n, T(0));
+        Array<T> residual = rhs;
+        Array<Low> correction(n, kUninitialized);
+        for (std::size_t iteration = 0; iteration <= max_refinements; ++iteration) {
+            for (std::size_t idx = 0; idx < n; ++idx) {
+                correction[idx] = static_cast<Low>(std::ldexp(residual[idx], -row_exponents_[idx]));
+            }
+            // the Low factors are not singular here
+            correction = *lu_.solve(std::move(correction));
+            for (std::size_t idx = 0; idx < n; ++idx) {
+                x[idx] += T(correction[idx]);
+            }
+
+            // residual = rhs - A * x, in T
+            residual = rhs;
+            kernels::gemm(n, 1, n, T(-1), matrix_.data(), matrix_.row_stride(), matrix_.col_stride(),
+                          x.begin(), std::size_t(1), std::size_t(1), T(1), residual.begin(), std::size_t(1));
+            stats::add(stats::Counter::Flops, 2 * n * n);
+
+            if (abs_max(residual) <= tolerance * abs_max(x)) {
+                return x;
+            }
+        }
+
+        // the refinement stalls when cond(A) approaches 1 / epsilon of Low
+        return high_precision_lu().solve(rhs);
+    }
+
+  private:
+    LU<T> high_precision_lu() const {
+        return Matrix<T>(matrix_).lu(block_size_, n_threads_);
+    }
+
+    // of the original matrix: det(A) = det(D * A) * 2^(sum of the row exponents)
+    ScaledProduct<T> diagonal_product() const {
+        stats::ScopedTimer timer(stats::Phase::Reduce);
+        ScaledProduct<T> product;
+        for (const int exponent : row_exponents_) {
+            product.exponent += exponent;
+        }
+        for (std::size_t idx = 0; idx < size(); ++idx) {
+            product.multiply(T(lu_.factors().row_begin(idx)[idx]));
+        }
+        return product;
+    }
+
+    static bool has_cancelled_pivot(const LU<Low>& lu) {
+        const Low threshold = std::sqrt(std::numeric_limits<Low>::epsilon());
+        for (std::size_t idx = 0; idx < lu.size(); ++idx) {
+            if (std::fabs(lu.factors().row_begin(idx)[idx]) < threshold) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // 2^e with the largest |element| of the row in [0.5, 1) * 2^e, 0 for zero rows
+    static std::vector<int> row_exponents(ConstMatrixView<T> matrix) {
+        std::vector<int> res(matrix.n_rows(), 0);
+        for (std::size_t row = 0; row < matrix.n_rows(); ++row) {
+            T max_abs = T(0);
+            for (std::size_t col = 0; col < matrix.n_cols(); ++col) {
+                max_abs = std::max(max_abs, std::fabs(matrix(row, col)));
+            }
+            std::frexp(max_abs, &res[row]);
+        }
+        return res;
+    }
+
+    static DenseArray<Low> to_low(ConstMatrixView<T> matrix, const std::vector<int>& exponents) {
+        assert(matrix.n_rows() == matrix.n_cols());
+        stats::ScopedTimer timer(stats::Phase::Copy);
+        DenseArray<Low> res(matrix.n_rows(), matrix.n_cols(), kUninitialized);
+        for (std::size_t row = 0; row < matrix.n_rows(); ++row) {
+            // multiplying by a power of two is exact and much cheaper than ldexp per element
+            const T scale = std::ldexp(T(1), -exponents[row]);
+            Low* dst = res.row_begin(row);
+            for (std::size_t col = 0; col < matrix.n_cols(); ++col) {
+                dst[col] = static_cast<Low>(matrix(row, col) * scale);
+            }
+        }
+        return res;
+    }
+
+    T inf_norm() const {
+        T res = T(0);
+        for (std::size_t row = 0; row < matrix_.n_rows(); ++row) {
+            T sum = T(0);
+            for (std::size_t col = 0; col < matrix_.n_cols(); ++col) {
+                sum += std::fabs(matrix_(row, col));
+            }
+            res = std::max(res, sum);
+        }
+        return res;
+    }
+
+    static T abs_max(const Array<T>& array) {
+        T res = T(0);
+        for (std::size_t idx = 0; idx < array.size(); ++idx) {
+            res = std::max(res, std::fabs(array[idx]));
+        }
+        return res;
+    }
+
+  private: // fields
+    ConstMatrixView<T> matrix_{};
+    std::size_t block_size_ = LU<Low>::kDefaultBlockSize;
+    std::size_t n_threads_ = 1;
+    std::vector<int> row_exponents_{};
+    LU<Low> lu_;
+    bool needs_high_precision_ = false;
+};
+
+// determinant of a T matrix at close to Low factorization speed
+template <FloatingPoint T, typename Alloc>
+T mixed_precision_determinant(const Matrix<T, Alloc>& matrix, const std::size_t n_threads = 1) {
+    return MixedPrecisionLU<T>(matrix.view(), LU<float>::kDefaultBlockSize, n_threads).determinant();
+}
+
+} // namespace mtx
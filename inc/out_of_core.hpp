@@ -0,0 +1,340 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <future>
+#include <limits>
+#include <numbers>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "binary_io.hpp"
+#include "common.hpp"
+#include "gemm.hpp"
+#include "jagged_array.hpp"
+#include "kernels.hpp"
+#include "lu.hpp"
+#include "stats.hpp"
+#include "thread_pool.hpp"
+
+namespace mtx {
+
+namespace detail {
+
+// unnamed temporary file, removed from the directory right away, so it goes away with the process
+class ScratchFile {
+  public:
+    ScratchFile() = default;
+
+    ScratchFile(const ScratchFile&) = delete;
+    ScratchFile& operator=(const ScratchFile&) = delete;
+
+    ~ScratchFile() {
+        if (fd_ >= 0) {
+            ::close(fd_);
+        }
+    }
+
+  public:
+    bool open(const std::string& dir) {
+        std::string path = dir + "/mtx-scratch-XXXXXX";
+        fd_ = ::mkstemp(path.data());
+        if (fd_ < 0) {
+            return false;
+        }
+        ::unlink(path.c_str());
+        return true;
+    }
+
+    // pread and pwrite may transfer less than asked, both loop until done
+    bool read(void* dst, std::size_t n_bytes, std::uint64_t offset) const {
+        char* ptr = static_cast<char*>(dst);
+        while (n_bytes > 0) {
+            const ssize_t n_read = ::pread(fd_, ptr, n_bytes, static_cast<off_t>(offset));
+            if (n_read <= 0) {
+                return false;
+            }
+            ptr += n_read;
+            n_bytes -= static_cast<std::size_t>(n_read);
+            offset += static_cast<std::uint64_t>(n_read);
+        }
+        return true;
+    }
+
+    bool write(const void* src, std::size_t n_bytes, std::uint64_t offset) const {
+        const char* ptr = static_cast<const char*>(src);
+        while (n_bytes > 0) {
+            const ssize_t n_written = ::pwrite(fd_, ptr, n_bytes, static_cast<off_t>(offset));
+            if (n_written <= 0) {
+                return false;
+            }
+            ptr += n_written;
+            n_bytes -= static_cast<std::size_t>(n_written);
+            offset += static_cast<std::uint64_t>(n_written);
+        }
+        return true;
+    }
+
+  private:
+    int fd_ = -1;
+};
+
+} // namespace detail
+
+// Out-of-core LU with partial pivoting for matrices larger than memory, left-looking over column
+// panels: panel p is loaded from the input, receives the row swaps and the updates of every L panel
+// left of it, streamed back from a scratch file, is factored in memory and its L part written out.
+// Only five panel buffers are allocated, the panel width is chosen so they fit into memory_budget:
+//  - the next input panel is copied from the mapping while the current one is processed;
+//  - L panel k + 1 is read from the scratch file while L panel k updates the current panel;
+//  - the finished panel is written back while the next one is processed, and it updates that next
+//    panel straight from memory.
+// L panels are stored as they were when factored; the swaps of later panels are applied to the
+// loaded copy, so the scratch file is written once per panel and never rewritten.
+// Only the pivots and the diagonal stay in memory, which is all the determinant needs.
+template <FloatingPoint T>
+class OutOfCoreLU {
+  public:
+    static constexpr std::size_t kDefaultMemoryBudget = std::size_t(1) << 30;
+    static constexpr std::size_t kBlockSize = LU<T>::kDefaultBlockSize;
+    static constexpr std::size_t kBuffers = 5;
+
+    explicit OutOfCoreLU(std::size_t memory_budget = kDefaultMemoryBudget, std::string scratch_dir = default_scratch_dir(),
+                         std::size_t n_threads = 1)
+        : memory_budget_(memory_budget), scratch_dir_(std::move(scratch_dir)), n_threads_(n_threads) {}
+
+    // $TMPDIR or /tmp
+    static std::string default_scratch_dir() {
+        const char* dir = std::getenv("TMPDIR");
+        return dir != nullptr && *dir != '\0' ? dir : "/tmp";
+    }
+
+    // false if the matrix is not square, the budget does not fit a single column per buffer
+    // or the scratch file can not be written
+    bool factorize(const MappedMatrix<T>& matrix) {
+        if (matrix.n_rows() != matrix.n_cols()) {
+            return false;
+        }
+        stats::ScopedTimer timer(stats::Phase::Factor);
+
+        size_ = matrix.n_rows();
+        pivots_.assign(size_, 0);
+        diagonal_.assign(size_, T(0));
+        permutation_sign_ = 1;
+        singular_ = false;
+        if (size_ == 0) {
+            return true;
+        }
+
+        panel_width_ = std::min(size_, memory_budget_ / (kBuffers * size_ * sizeof(T)));
+        if (panel_width_ == 0) {
+            return false;
+        }
+        detail::ScratchFile scratch;
+        if (!scratch.open(scratch_dir_)) {
+            return false;
+        }
+
+        std::optional<ThreadPool> thread_pool;
+        if (n_threads_ > 1) {
+            thread_pool.emplace(n_threads_);
+        }
+        ThreadPool* pool = thread_pool ? &*thread_pool : nullptr;
+
+        const std::size_t n_panels = (size_ + panel_width_ - 1) / panel_width_;
+        // L panel p keeps the rows [begin(p), size_) at offsets[p]
+        std::vector<std::uint64_t> offsets(n_panels + 1, 0);
+        for (std::size_t p = 0; p < n_panels; ++p) {
+            offsets[p + 1] = offsets[p] + (size_ - begin(p)) * width(p) * sizeof(T);
+        }
+
+        std::array<Array<T>, kBuffers> storage;
+        for (Array<T>& buffer : storage) {
+            buffer = Array<T>(size_ * panel_width_, kUninitialized);
+        }
+        T* panel = storage[0].begin();
+        T* next_panel = storage[1].begin();
+        T* written = storage[2].begin();
+        std::array<T*, 2> streamed = {storage[3].begin(), storage[4].begin()};
+
+        // the rows of the input as they are, the swaps are applied once the panel is current
+        auto load_input = [&matrix, this](T* dst, std::size_t p) {
+            for (std::size_t row = 0; row < size_; ++row) {
+                std::copy_n(matrix.row_begin(row) + begin(p), width(p), dst + row * width(p));
+            }
+            return true;
+        };
+        auto read_panel = [&scratch, &offsets, this](T* dst, std::size_t p) {
+            return scratch.read(dst, offsets[p + 1] - offsets[p], offsets[p]);
+        };
+        auto write_panel = [&scratch, &offsets, this](const T* src, std::size_t p) {
+            return scratch.write(src + begin(p) * width(p), offsets[p + 1] - offsets[p], offsets[p]);
+        };
+        auto wait = [](std::future<bool>& future) {
+            stats::ScopedTimer io_timer(stats::Phase::IoWait);
+            return !future.valid() || future.get();
+        };
+
+        // the futures are destroyed, and so waited for, before the buffers
+        std::future<bool> next_input = std::async(std::launch::async, load_input, next_panel, 0);
+        std::future<bool> write_back;
+        std::future<bool> prefetch;
+
+        for (std::size_t p = 0; p < n_panels; ++p) {
+            if (!wait(next_input)) {
+                return false;
+            }
+            std::swap(panel, next_panel);
+            if (p + 1 < n_panels) {
+                next_input = std::async(std::launch::async, load_input, next_panel, p + 1);
+            }
+            apply_swaps(panel, width(p), 0, 0, begin(p));
+
+            // L panel p - 1 is still in memory, the older ones come from the scratch file
+            if (p >= 2) {
+                prefetch = std::async(std::launch::async, read_panel, streamed[0], 0);
+            }
+            for (std::size_t k = 0; k < p; ++k) {
+                if (k + 1 == p) {
+                    update(written + begin(k) * width(k), k, panel, p, pool);
+                    continue;
+                }
+                if (!wait(prefetch)) {
+                    return false;
+                }
+                T* l_panel = streamed[k % 2];
+                if (k + 2 < p) {
+                    prefetch = std::async(std::launch::async, read_panel, streamed[(k + 1) % 2], k + 1);
+                }
+                apply_swaps(l_panel, width(k), begin(k), begin(k) + width(k), begin(p));
+                update(l_panel, k, panel, p, pool);
+            }
+
+            factor_panel(panel, p, pool);
+
+            if (p + 1 < n_panels) {
+                if (!wait(write_back)) {
+                    return false;
+                }
+                std::swap(panel, written);
+                write_back = std::async(std::launch::async, write_panel, written, p);
+            }
+        }
+        return wait(write_back);
+    }
+
+  public: // getters
+    std::size_t size() const { return size_; }
+    std::size_t panel_width() const { return panel_width_; }
+
+    // at step i row i was swapped with row pivots()[i]
+    const std::vector<std::size_t>& pivots() const { return pivots_; }
+    int permutation_sign() const { return permutation_sign_; }
+
+    bool is_singular() const { return singular_; }
+
+  public: // math
+    T determinant() const {
+        if (singular_) {
+            return T(0);
+        }
+        return scaled_determinant(diagonal_product(), permutation_sign_);
+    }
+
+    LogDeterminant<T> log_abs_determinant() const {
+        if (singular_) {
+            return {T(0), -std::numeric_limits<T>::infinity()};
+        }
+        return scaled_log_determinant(diagonal_product(), permutation_sign_);
+    }
+
+  private:
+    ScaledProduct<T> diagonal_product() const {
+        stats::ScopedTimer timer(stats::Phase::Reduce);
+        ScaledProduct<T> product;
+        for (const T value : diagonal_) {
+            product.multiply(value);
+        }
+        return product;
+    }
+
+    std::size_t begin(std::size_t p) const { return p * panel_width_; }
+    std::size_t width(std::size_t p) const { return std::min(panel_width_, size_ - begin(p)); }
+
+    // the swaps of the steps [first, last) on the rows [first_row, size_) stored with leading dimension ld
+    void apply_swaps(T* rows, std::size_t ld, std::size_t first_row, std::size_t first, std::size_t last) const {
+        for (std::size_t row = first; row < last; ++row) {
+            if (pivots_[row] != row) {
+                T* current = rows + (row - first_row) * ld;
+                std::swap_ranges(current, current + ld, rows + (pivots_[row] - first_row) * ld);
+            }
+        }
+    }
+
+    // the contribution of L panel k (rows [begin(k), size_), leading dimension width(k)) to panel p
+    void update(const T* l_panel, std::size_t k, T* panel, std::size_t p, ThreadPool* pool) const {
+        const std::size_t first = begin(k);
+        const std::size_t l_width = width(k);
+        const std::size_t ld = width(p);
+        detail::solve_unit_lower(l_panel, l_width, l_width, panel + first * ld, ld, ld, kBlockSize, pool);
+
+        const std::size_t n_below = size_ - first - l_width;
+        stats::add(stats::Counter::Flops, 2 * n_below * ld * l_width);
+        kernels::gemm(n_below, ld, l_width, T(-1), l_panel + l_width * l_width, l_width,
+                      panel + first * ld, ld, T(1), panel + (first + l_width) * ld, ld, pool);
+    }
+
+    // in-memory LU of the rows [begin(p), size_) of panel p, in blocks of kBlockSize columns with the
+    // panel kernels of LU; swaps move whole panel rows, the U rows above begin(p) are not touched
+    void factor_panel(T* panel, std::size_t p, ThreadPool* pool) {
+        const std::size_t ld = width(p);
+        const std::size_t offset = begin(p);
+        auto row_ptr = [&](std::size_t row) { return panel + row * ld; };
+
+        for (std::size_t first = 0; first < ld; first += kBlockSize) {
+            const std::size_t last = std::min(ld, first + kBlockSize);
+            const std::size_t diag = offset + first;
+            const detail::PanelPivoting pivoting = detail::factor_panel(
+                row_ptr(diag) + first, ld, size_ - diag, last - first, diag, pivots_.data() + diag,
+                [&](std::size_t row, std::size_t other) { std::swap_ranges(row_ptr(row), row_ptr(row) + ld, row_ptr(other)); });
+            permutation_sign_ *= pivoting.sign;
+            singular_ = singular_ || pivoting.singular;
+            for (std::size_t col = first; col < last; ++col) {
+                diagonal_[offset + col] = row_ptr(offset + col)[col];
+            }
+
+            if (last < ld) {
+                const std::size_t n_below = size_ - offset - last;
+                detail::solve_unit_lower(row_ptr(diag) + first, ld, last - first, row_ptr(diag) + last, ld, ld - last,
+                                         kBlockSize, pool);
+                stats::add(stats::Counter::Flops, 2 * n_below * (ld - last) * (last - first));
+                kernels::gemm(n_below, ld - last, last - first, T(-1), row_ptr(offset + last) + first, ld,
+                              row_ptr(diag) + last, ld, T(1), row_ptr(offset + last) + last, ld, pool);
+            }
+        }
+    }
+
+  private: // fields
+    std::size_t memory_budget_ = kDefaultMemoryBudget;
+    std::string scratch_dir_{};
+    std::size_t n_threads_ = 1;
+
+    std::size_t size_ = 0;
+    std::size_t panel_width_ = 0;
+    std::vector<std::size_t> pivots_{};
+    std::vector<T> diagonal_{};
+    int permutation_sign_ = 1;
+    bool singular_ = false;
+};
+
+} // namespace mtx
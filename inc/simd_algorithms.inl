@@ -0,0 +1,176 @@
+// Bodies of the element-wise and GEMM kernels, shared by every instruction set.
+// simd_kernels.hpp includes this file once per instruction set, inside that set's namespace
+// and target region, after defining VecTraits, the v* vector operations and scalar_fmadd.
+// x and y must either be the same pointer or not overlap.
+
+template <typename T>
+inline void add(std::size_t n, const T* x, T* y) {
+    constexpr std::size_t width = VecTraits<T>::width;
+    std::size_t idx = 0;
+    for (; idx + 2 * width <= n; idx += 2 * width) {
+        vstore(y + idx, vadd(vload(y + idx), vload(x + idx)));
+        vstore(y + idx + width, vadd(vload(y + idx + width), vload(x + idx + width)));
+    }
+    for (; idx + width <= n; idx += width) {
+        vstore(y + idx, vadd(vload(y + idx), vload(x + idx)));
+    }
+    for (; idx < n; ++idx) {
+        y[idx] += x[idx];
+    }
+}
+
+template <typename T>
+inline void sub(std::size_t n, const T* x, T* y) {
+    constexpr std::size_t width = VecTraits<T>::width;
+    std::size_t idx = 0;
+    for (; idx + 2 * width <= n; idx += 2 * width) {
+        vstore(y + idx, vsub(vload(y + idx), vload(x + idx)));
+        vstore(y + idx + width, vsub(vload(y + idx + width), vload(x + idx + width)));
+    }
+    for (; idx + width <= n; idx += width) {
+        vstore(y + idx, vsub(vload(y + idx), vload(x + idx)));
+    }
+    for (; idx < n; ++idx) {
+        y[idx] -= x[idx];
+    }
+}
+
+template <typename T>
+inline void scale(std::size_t n, T alpha, T* y) {
+    constexpr std::size_t width = VecTraits<T>::width;
+    const auto alpha_vec = vbroadcast(alpha);
+    std::size_t idx = 0;
+    for (; idx + 2 * width <= n; idx += 2 * width) {
+        vstore(y + idx, vmul(vload(y + idx), alpha_vec));
+        vstore(y + idx + width, vmul(vload(y + idx + width), alpha_vec));
+    }
+    for (; idx + width <= n; idx += width) {
+        vstore(y + idx, vmul(vload(y + idx), alpha_vec));
+    }
+    for (; idx < n; ++idx) {
+        y[idx] *= alpha;
+    }
+}
+
+template <typename T>
+inline void axpy(std::size_t n, T alpha, const T* x, T* y) {
+    constexpr std::size_t width = VecTraits<T>::width;
+    const auto alpha_vec = vbroadcast(alpha);
+    std::size_t idx = 0;
+    for (; idx + 2 * width <= n; idx += 2 * width) {
+        vstore(y + idx, vfmadd(alpha_vec, vload(x + idx), vload(y + idx)));
+        vstore(y + idx + width, vfmadd(alpha_vec, vload(x + idx + width), vload(y + idx + width)));
+    }
+    for (; idx + width <= n; idx += width) {
+        vstore(y + idx, vfmadd(alpha_vec, vload(x + idx), vload(y + idx)));
+    }
+    for (; idx < n; ++idx) {
+        y[idx] = scalar_fmadd(alpha, x[idx], y[idx]);
+    }
+}
+
+// y[block * lanes + lane] += alpha[lane] * x[block * lanes + lane]: axpy with a separate alpha per lane,
+// lanes must be a multiple of the vector width (used to update many small matrices at once)
+template <std::size_t lanes, typename T>
+inline void lane_axpy(std::size_t n_blocks, const T* alpha, const T* x, T* y) {
+    constexpr std::size_t width = VecTraits<T>::width;
+    constexpr std::size_t n_vecs = lanes / width;
+    static_assert(n_vecs * width == lanes);
+
+    decltype(vbroadcast(T{})) alpha_vec[n_vecs];
+    for (std::size_t vec = 0; vec < n_vecs; ++vec) {
+        alpha_vec[vec] = vload(alpha + vec * width);
+    }
+
+    for (std::size_t block = 0; block < n_blocks; ++block) {
+        const T* x_block = x + block * lanes;
+        T* y_block = y + block * lanes;
+#pragma GCC unroll 16
+        for (std::size_t vec = 0; vec < n_vecs; ++vec) {
+            vstore(y_block + vec * width, vfmadd(alpha_vec[vec], vload(x_block + vec * width), vload(y_block + vec * width)));
+        }
+    }
+}
+
+// index of the first element with the largest absolute value, 0 for an empty range
+template <typename T>
+inline std::size_t iamax(std::size_t n, const T* x) {
+    if (n == 0) {
+        return 0;
+    }
+
+    constexpr std::size_t width = VecTraits<T>::width;
+    T max_value = std::fabs(x[0]);
+    std::size_t idx = 0;
+    if (n >= width) {
+        auto max_vec = vabs(vload(x));
+        for (idx = width; idx + width <= n; idx += width) {
+            max_vec = vmax(max_vec, vabs(vload(x + idx)));
+        }
+        max_value = vreduce_max(max_vec);
+    }
+    for (; idx < n; ++idx) {
+        max_value = std::max(max_value, T(std::fabs(x[idx])));
+    }
+
+    for (idx = 0; idx < n; ++idx) {
+        if (std::fabs(x[idx]) == max_value) {
+            return idx;
+        }
+    }
+    return 0;
+}
+
+// register-blocked GEMM micro-kernel: C[0:m, 0:n] += alpha * A_panel * B_panel for one mr x nr tile,
+// A_panel holds k packed columns of mr values, B_panel holds k packed rows of nr values
+template <typename T>
+struct GemmKernel {
+    static constexpr std::size_t mr = 6;
+    static constexpr std::size_t nr = 2 * VecTraits<T>::width;
+
+    static void micro_kernel(std::size_t k, const T* a, const T* b, T alpha, T* c, std::size_t ldc,
+                             std::size_t m, std::size_t n) {
+        constexpr std::size_t width = VecTraits<T>::width;
+        using Vec = decltype(vbroadcast(T{}));
+
+        Vec acc[mr][2];
+#pragma GCC unroll 8
+        for (std::size_t row = 0; row < mr; ++row) {
+            acc[row][0] = vbroadcast(T(0));
+            acc[row][1] = vbroadcast(T(0));
+        }
+
+        for (std::size_t inner = 0; inner < k; ++inner) {
+            const Vec b_lo = vload(b + inner * nr);
+            const Vec b_hi = vload(b + inner * nr + width);
+#pragma GCC unroll 8
+            for (std::size_t row = 0; row < mr; ++row) {
+                const Vec a_elem = vbroadcast(a[inner * mr + row]);
+                acc[row][0] = vfmadd(a_elem, b_lo, acc[row][0]);
+                acc[row][1] = vfmadd(a_elem, b_hi, acc[row][1]);
+            }
+        }
+
+        const Vec alpha_vec = vbroadcast(alpha);
+        if (m == mr && n == nr) {
+#pragma GCC unroll 8
+            for (std::size_t row = 0; row < mr; ++row) {
+                T* c_row = c + row * ldc;
+                vstore(c_row, vfmadd(alpha_vec, acc[row][0], vload(c_row)));
+                vstore(c_row + width, vfmadd(alpha_vec, acc[row][1], vload(c_row + width)));
+            }
+            return;
+        }
+
+        T tile[mr * nr];
+        for (std::size_t row = 0; row < mr; ++row) {
+            vstore(tile + row * nr, acc[row][0]);
+            vstore(tile + row * nr + width, acc[row][1]);
+        }
+        for (std::size_t row = 0; row < m; ++row) {
+            for (std::size_t col = 0; col < n; ++col) {
+                c[row * ldc + col] = scalar_fmadd(alpha, tile[row * nr + col], c[row * ldc + col]);
+            }
+        }
+    }
+};
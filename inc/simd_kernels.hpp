@@ -0,0 +1,266 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__)) && !defined(MTX_DISABLE_SIMD)
+#define MTX_SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+namespace mtx::kernels {
+
+// instruction sets with a dedicated kernel implementation, ordered from the weakest
+enum class SimdLevel { Scalar = 0, SSE2 = 1, AVX2 = 2, AVX512 = 3 };
+
+template <typename T>
+concept SimdScalar = std::same_as<T, float> || std::same_as<T, double>;
+
+// ------------------------------------ scalar fallback ----------------------------------------------
+
+namespace scalar {
+
+template <typename T>
+struct VecTraits {
+    static constexpr std::size_t width = 1;
+};
+
+template <typename T> inline T vload(const T* ptr) { return *ptr; }
+template <typename T> inline void vstore(T* ptr, T value) { *ptr = value; }
+template <typename T> inline T vbroadcast(T value) { return value; }
+template <typename T> inline T vadd(T a, T b) { return a + b; }
+template <typename T> inline T vsub(T a, T b) { return a - b; }
+template <typename T> inline T vmul(T a, T b) { return a * b; }
+template <typename T> inline T vfmadd(T a, T b, T c) { return a * b + c; }
+template <typename T> inline T vabs(T a) { return std::fabs(a); }
+template <typename T> inline T vmax(T a, T b) { return std::max(a, b); }
+template <typename T> inline T vreduce_max(T a) { return a; }
+template <typename T> inline T scalar_fmadd(T a, T b, T c) { return a * b + c; }
+
+#include "simd_algorithms.inl"
+
+} // namespace scalar
+
+#ifdef MTX_SIMD_X86
+
+// ------------------------------------ SSE2 ---------------------------------------------------------
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("sse2"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("sse2")
+#endif
+
+namespace sse2 {
+
+template <typename T> struct VecTraits;
+template <> struct VecTraits<double> { static constexpr std::size_t width = 2; };
+template <> struct VecTraits<float> { static constexpr std::size_t width = 4; };
+
+inline __m128d vload(const double* ptr) { return _mm_loadu_pd(ptr); }
+inline __m128 vload(const float* ptr) { return _mm_loadu_ps(ptr); }
+inline void vstore(double* ptr, __m128d value) { _mm_storeu_pd(ptr, value); }
+inline void vstore(float* ptr, __m128 value) { _mm_storeu_ps(ptr, value); }
+inline __m128d vbroadcast(double value) { return _mm_set1_pd(value); }
+inline __m128 vbroadcast(float value) { return _mm_set1_ps(value); }
+inline __m128d vadd(__m128d a, __m128d b) { return _mm_add_pd(a, b); }
+inline __m128 vadd(__m128 a, __m128 b) { return _mm_add_ps(a, b); }
+inline __m128d vsub(__m128d a, __m128d b) { return _mm_sub_pd(a, b); }
+inline __m128 vsub(__m128 a, __m128 b) { return _mm_sub_ps(a, b); }
+inline __m128d vmul(__m128d a, __m128d b) { return _mm_mul_pd(a, b); }
+inline __m128 vmul(__m128 a, __m128 b) { return _mm_mul_ps(a, b); }
+inline __m128d vfmadd(__m128d a, __m128d b, __m128d c) { return _mm_add_pd(_mm_mul_pd(a, b), c); }
+inline __m128 vfmadd(__m128 a, __m128 b, __m128 c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+inline __m128d vabs(__m128d a) { return _mm_andnot_pd(_mm_set1_pd(-0.0), a); }
+inline __m128 vabs(__m128 a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+inline __m128d vmax(__m128d a, __m128d b) { return _mm_max_pd(a, b); }
+inline __m128 vmax(__m128 a, __m128 b) { return _mm_max_ps(a, b); }
+
+inline double vreduce_max(__m128d a) {
+    return _mm_cvtsd_f64(_mm_max_sd(a, _mm_unpackhi_pd(a, a)));
+}
+
+inline float vreduce_max(__m128 a) {
+    a = _mm_max_ps(a, _mm_movehl_ps(a, a));
+    a = _mm_max_ss(a, _mm_shuffle_ps(a, a, 1));
+    return _mm_cvtss_f32(a);
+}
+
+template <typename T> inline T scalar_fmadd(T a, T b, T c) { return a * b + c; }
+
+#include "simd_algorithms.inl"
+
+} // namespace sse2
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+
+// ------------------------------------ AVX2 + FMA ---------------------------------------------------
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2,fma"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("avx2,fma")
+#endif
+
+namespace avx2 {
+
+template <typename T> struct VecTraits;
+template <> struct VecTraits<double> { static constexpr std::size_t width = 4; };
+template <> struct VecTraits<float> { static constexpr std::size_t width = 8; };
+
+inline __m256d vload(const double* ptr) { return _mm256_loadu_pd(ptr); }
+inline __m256 vload(const float* ptr) { return _mm256_loadu_ps(ptr); }
+inline void vstore(double* ptr, __m256d value) { _mm256_storeu_pd(ptr, value); }
+inline void vstore(float* ptr, __m256 value) { _mm256_storeu_ps(ptr, value); }
+inline __m256d vbroadcast(double value) { return _mm256_set1_pd(value); }
+inline __m256 vbroadcast(float value) { return _mm256_set1_ps(value); }
+inline __m256d vadd(__m256d a, __m256d b) { return _mm256_add_pd(a, b); }
+inline __m256 vadd(__m256 a, __m256 b) { return _mm256_add_ps(a, b); }
+inline __m256d vsub(__m256d a, __m256d b) { return _mm256_sub_pd(a, b); }
+inline __m256 vsub(__m256 a, __m256 b) { return _mm256_sub_ps(a, b); }
+inline __m256d vmul(__m256d a, __m256d b) { return _mm256_mul_pd(a, b); }
+inline __m256 vmul(__m256 a, __m256 b) { return _mm256_mul_ps(a, b); }
+inline __m256d vfmadd(__m256d a, __m256d b, __m256d c) { return _mm256_fmadd_pd(a, b, c); }
+inline __m256 vfmadd(__m256 a, __m256 b, __m256 c) { return _mm256_fmadd_ps(a, b, c); }
+inline __m256d vabs(__m256d a) { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a); }
+inline __m256 vabs(__m256 a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+inline __m256d vmax(__m256d a, __m256d b) { return _mm256_max_pd(a, b); }
+inline __m256 vmax(__m256 a, __m256 b) { return _mm256_max_ps(a, b); }
+
+inline double vreduce_max(__m256d a) {
+    __m128d half = _mm_max_pd(_mm256_castpd256_pd128(a), _mm256_extractf128_pd(a, 1));
+    return _mm_cvtsd_f64(_mm_max_sd(half, _mm_unpackhi_pd(half, half)));
+}
+
+inline float vreduce_max(__m256 a) {
+    __m128 half = _mm_max_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1));
+    half = _mm_max_ps(half, _mm_movehl_ps(half, half));
+    half = _mm_max_ss(half, _mm_shuffle_ps(half, half, 1));
+    return _mm_cvtss_f32(half);
+}
+
+// tails are fused as well, so an element rounds the same way whichever loop handles it
+template <typename T> inline T scalar_fmadd(T a, T b, T c) { return std::fma(a, b, c); }
+
+#include "simd_algorithms.inl"
+
+} // namespace avx2
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+
+// ------------------------------------ AVX-512F -----------------------------------------------------
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx512f"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+#endif
+
+namespace avx512 {
+
+template <typename T> struct VecTraits;
+template <> struct VecTraits<double> { static constexpr std::size_t width = 8; };
+template <> struct VecTraits<float> { static constexpr std::size_t width = 16; };
+
+inline __m512d vload(const double* ptr) { return _mm512_loadu_pd(ptr); }
+inline __m512 vload(const float* ptr) { return _mm512_loadu_ps(ptr); }
+inline void vstore(double* ptr, __m512d value) { _mm512_storeu_pd(ptr, value); }
+inline void vstore(float* ptr, __m512 value) { _mm512_storeu_ps(ptr, value); }
+inline __m512d vbroadcast(double value) { return _mm512_set1_pd(value); }
+inline __m512 vbroadcast(float value) { return _mm512_set1_ps(value); }
+inline __m512d vadd(__m512d a, __m512d b) { return _mm512_add_pd(a, b); }
+inline __m512 vadd(__m512 a, __m512 b) { return _mm512_add_ps(a, b); }
+inline __m512d vsub(__m512d a, __m512d b) { return _mm512_sub_pd(a, b); }
+inline __m512 vsub(__m512 a, __m512 b) { return _mm512_sub_ps(a, b); }
+inline __m512d vmul(__m512d a, __m512d b) { return _mm512_mul_pd(a, b); }
+inline __m512 vmul(__m512 a, __m512 b) { return _mm512_mul_ps(a, b); }
+inline __m512d vfmadd(__m512d a, __m512d b, __m512d c) { return _mm512_fmadd_pd(a, b, c); }
+inline __m512 vfmadd(__m512 a, __m512 b, __m512 c) { return _mm512_fmadd_ps(a, b, c); }
+inline __m512d vabs(__m512d a) { return _mm512_abs_pd(a); }
+inline __m512 vabs(__m512 a) { return _mm512_abs_ps(a); }
+// GCC's plain max and extract intrinsics (the 512->256 casts and _mm512_reduce_max_* included)
+// merge into _mm*_undefined_* and trip -Wmaybe-uninitialized, the masked forms get a defined source
+inline __m512d vmax(__m512d a, __m512d b) { return _mm512_mask_max_pd(a, __mmask8(-1), a, b); }
+inline __m512 vmax(__m512 a, __m512 b) { return _mm512_mask_max_ps(a, __mmask16(-1), a, b); }
+template <int Half> inline __m256d vhalf(__m512d a) {
+    return _mm512_mask_extractf64x4_pd(_mm256_setzero_pd(), __mmask8(-1), a, Half);
+}
+// through the double view, _mm512_extractf32x8_ps needs AVX512DQ
+template <int Half> inline __m256 vhalf(__m512 a) { return _mm256_castpd_ps(vhalf<Half>(_mm512_castps_pd(a))); }
+inline double vreduce_max(__m512d a) {
+    const __m256d half = _mm256_max_pd(vhalf<0>(a), vhalf<1>(a));
+    const __m128d quarter = _mm_max_pd(_mm256_castpd256_pd128(half), _mm256_extractf128_pd(half, 1));
+    return _mm_cvtsd_f64(_mm_max_sd(quarter, _mm_unpackhi_pd(quarter, quarter)));
+}
+inline float vreduce_max(__m512 a) {
+    const __m256 half = _mm256_max_ps(vhalf<0>(a), vhalf<1>(a));
+    __m128 quarter = _mm_max_ps(_mm256_castps256_ps128(half), _mm256_extractf128_ps(half, 1));
+    quarter = _mm_max_ps(quarter, _mm_movehl_ps(quarter, quarter));
+    quarter = _mm_max_ss(quarter, _mm_shuffle_ps(quarter, quarter, 1));
+    return _mm_cvtss_f32(quarter);
+}
+
+template <typename T> inline T scalar_fmadd(T a, T b, T c) { return std::fma(a, b, c); }
+
+#include "simd_algorithms.inl"
+
+} // namespace avx512
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+
+#endif // MTX_SIMD_X86
+
+// ------------------------------------ runtime dispatch ---------------------------------------------
+
+inline SimdLevel detect_simd_level() {
+#ifdef MTX_SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        return SimdLevel::AVX512;
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return SimdLevel::AVX2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return SimdLevel::SSE2;
+    }
+#endif
+    return SimdLevel::Scalar;
+}
+
+namespace detail {
+
+inline SimdLevel& active_simd_level() {
+    static SimdLevel level = detect_simd_level();
+    return level;
+}
+
+} // namespace detail
+
+inline SimdLevel simd_level() {
+    return detail::active_simd_level();
+}
+
+// restricts kernels to the given level (clamped to what the cpu supports), mostly for tests and benchmarks
+inline void set_simd_level(SimdLevel level) {
+    detail::active_simd_level() = std::min(level, detect_simd_level());
+}
+
+} // namespace mtx::kernels
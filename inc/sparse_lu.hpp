@@ -0,0 +1,314 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <iterator>
+#include <limits>
+#include <numbers>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "common.hpp"
+#include "lu.hpp"
+#include "sparse_matrix.hpp"
+#include "stats.hpp"
+
+namespace mtx {
+
+// ------------------------------------ fill-reducing ordering ---------------------------------------
+
+// Minimum degree ordering of the pattern of A + A^T: the vertex with the fewest neighbours is
+// eliminated next and its neighbours become a clique. Degrees are exact (no approximation or
+// supervariables as in AMD), the elimination graph never holds more edges than the Cholesky
+// factor of A + A^T, so memory follows the fill rather than n^2.
+// Returns order, where order[k] is the original index eliminated at step k.
+template <FloatingPoint T>
+std::vector<std::size_t> minimum_degree_ordering(const SparseMatrix<T, SparseFormat::Csc>& matrix) {
+    assert(matrix.n_rows() == matrix.n_cols());
+    const std::size_t n = matrix.n_cols();
+
+    std::vector<std::vector<std::size_t>> adjacency(n);
+    for (std::size_t col = 0; col < n; ++col) {
+        for (std::size_t pos = matrix.offsets()[col]; pos < matrix.offsets()[col + 1]; ++pos) {
+            const std::size_t row = matrix.indices()[pos];
+            if (row != col) {
+                adjacency[row].push_back(col);
+                adjacency[col].push_back(row);
+            }
+        }
+    }
+
+    std::set<std::pair<std::size_t, std::size_t>> by_degree;
+    for (std::size_t vertex = 0; vertex < n; ++vertex) {
+        std::vector<std::size_t>& neighbours = adjacency[vertex];
+        std::sort(neighbours.begin(), neighbours.end());
+        neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+        by_degree.emplace(neighbours.size(), vertex);
+    }
+
+    std::vector<std::size_t> order;
+    order.reserve(n);
+    std::vector<std::size_t> merged;
+    while (!by_degree.empty()) {
+        const std::size_t pivot = by_degree.begin()->second;
+        by_degree.erase(by_degree.begin());
+        order.push_back(pivot);
+
+        // neighbours of an eliminated vertex are never eliminated, pivot is dropped from their lists below
+        const std::vector<std::size_t> clique = std::move(adjacency[pivot]);
+        adjacency[pivot] = {};
+        for (const std::size_t vertex : clique) {
+            std::vector<std::size_t>& neighbours = adjacency[vertex];
+            by_degree.erase({neighbours.size(), vertex});
+
+            merged.clear();
+            std::set_union(neighbours.begin(), neighbours.end(), clique.begin(), clique.end(), std::back_inserter(merged));
+            std::erase_if(merged, [&](std::size_t other) { return other == vertex || other == pivot; });
+            neighbours.swap(merged);
+
+            by_degree.emplace(neighbours.size(), vertex);
+        }
+    }
+    return order;
+}
+
+// ------------------------------------ sparse LU ----------------------------------------------------
+
+// Left-looking sparse LU (Gilbert-Peierls) with threshold partial pivoting: P * A * Q = L * U.
+// Q is a fill-reducing column ordering (minimum degree of A + A^T), each column of L and U is
+// found by a sparse triangular solve whose pattern comes from a depth-first search over L,
+// so the work is proportional to the flops on non-zeros, not to n^2.
+// The diagonal of the ordered matrix is kept as the pivot while it is at least tolerance times
+// the largest candidate, which preserves the ordering; tolerance 1 is plain partial pivoting.
+template <FloatingPoint T>
+class SparseLU {
+  public:
+    static constexpr T kDefaultTolerance = T(0.1);
+
+    explicit SparseLU(const SparseMatrix<T, SparseFormat::Csc>& matrix, T tolerance = kDefaultTolerance)
+        : column_order_(minimum_degree_ordering(matrix))
+    {
+        assert(matrix.n_rows() == matrix.n_cols());
+        assert(tolerance > T(0) && tolerance <= T(1));
+        factorize(matrix, tolerance);
+    }
+
+  public: // getters
+    std::size_t size() const { return column_order_.size(); }
+
+    // L has a unit diagonal and is stored first in each column; U stores the diagonal last
+    const SparseMatrix<T, SparseFormat::Csc>& lower() const { return lower_; }
+    const SparseMatrix<T, SparseFormat::Csc>& upper() const { return upper_; }
+
+    // column k of L * U is the original column column_order()[k], original row i is row row_position()[i]
+    const std::vector<std::size_t>& column_order() const { return column_order_; }
+    const std::vector<std::size_t>& row_position() const { return row_position_; }
+
+    bool is_singular() const { return singular_; }
+
+  public: // math
+    T determinant() const {
+        if (singular_) {
+            return T(0);
+        }
+        return scaled_determinant(diagonal_product(), permutation_sign_);
+    }
+
+    LogDeterminant<T> log_abs_determinant() const {
+        if (singular_) {
+            return {T(0), -std::numeric_limits<T>::infinity()};
+        }
+        return scaled_log_determinant(diagonal_product(), permutation_sign_);
+    }
+
+  private: // determinant details
+    // the diagonal of U is the last entry of every column
+    ScaledProduct<T> diagonal_product() const {
+        stats::ScopedTimer timer(stats::Phase::Reduce);
+        ScaledProduct<T> product;
+        for (std::size_t col = 0; col < size(); ++col) {
+            product.multiply(upper_.values()[upper_.offsets()[col + 1] - 1]);
+        }
+        return product;
+    }
+
+  private: // factorization details
+    static constexpr std::size_t kNone = std::numeric_limits<std::size_t>::max();
+
+    void factorize(const SparseMatrix<T, SparseFormat::Csc>& matrix, const T tolerance) {
+        stats::ScopedTimer timer(stats::Phase::Factor);
+        const std::size_t n = size();
+        row_position_.assign(n, kNone);
+
+        std::vector<std::size_t> l_offsets{0}, l_indices;
+        std::vector<std::size_t> u_offsets{0}, u_indices;
+        std::vector<T> l_values, u_values;
+        l_indices.reserve(matrix.nnz() + n);
+        l_values.reserve(matrix.nnz() + n);
+        u_indices.reserve(matrix.nnz() + n);
+        u_values.reserve(matrix.nnz() + n);
+
+        std::vector<T> work(n, T(0));
+        std::vector<std::size_t> pattern;
+        std::vector<char> visited(n, 0);
+        std::vector<std::pair<std::size_t, std::size_t>> dfs_stack;
+
+        for (std::size_t step = 0; step < n; ++step) {
+            const std::size_t col = column_order_[step];
+
+            // rows reachable from A(:, col) through the columns of L computed so far, in topological order
+            pattern.clear();
+            for (std::size_t pos = matrix.offsets()[col]; pos < matrix.offsets()[col + 1]; ++pos) {
+                const std::size_t start = matrix.indices()[pos];
+                if (visited[start]) {
+                    continue;
+                }
+                visited[start] = 1;
+                dfs_stack.emplace_back(start, 0);
+                while (!dfs_stack.empty()) {
+                    auto& [row, child] = dfs_stack.back();
+                    const std::size_t l_col = row_position_[row];
+                    const std::size_t child_count = l_col == kNone ? 0 : l_offsets[l_col + 1] - l_offsets[l_col] - 1;
+                    if (child < child_count) {
+                        const std::size_t next = l_indices[l_offsets[l_col] + 1 + child++];
+                        if (!visited[next]) {
+                            visited[next] = 1;
+                            dfs_stack.emplace_back(next, 0);
+                        }
+                        continue;
+                    }
+                    pattern.push_back(row);
+                    dfs_stack.pop_back();
+                }
+            }
+            std::reverse(pattern.begin(), pattern.end());
+
+            // work = L \ A(:, col) on the pattern only
+            for (std::size_t pos = matrix.offsets()[col]; pos < matrix.offsets()[col + 1]; ++pos) {
+                work[matrix.indices()[pos]] = matrix.values()[pos];
+            }
+            for (const std::size_t row : pattern) {
+                visited[row] = 0;
+                const std::size_t l_col = row_position_[row];
+                if (l_col == kNone) {
+                    continue;
+                }
+                const T value = work[row];
+                stats::add(stats::Counter::Flops, 2 * (l_offsets[l_col + 1] - l_offsets[l_col] - 1));
+                for (std::size_t pos = l_offsets[l_col] + 1; pos < l_offsets[l_col + 1]; ++pos) {
+                    work[l_indices[pos]] -= l_values[pos] * value;
+                }
+            }
+
+            // rows already pivoted go to U, the largest remaining one becomes the pivot
+            stats::add(stats::Counter::PivotSearches);
+            std::size_t pivot_row = kNone;
+            T pivot_abs = T(0);
+            for (const std::size_t row : pattern) {
+                if (row_position_[row] != kNone) {
+                    u_indices.push_back(row_position_[row]);
+                    u_values.push_back(work[row]);
+                } else if (std::fabs(work[row]) > pivot_abs) {
+                    pivot_abs = std::fabs(work[row]);
+                    pivot_row = row;
+                }
+            }
+            // only an exact zero, as in the dense LU
+            if (pivot_row == kNone || pivot_abs == T(0)) {
+                singular_ = true;
+                return;
+            }
+            if (row_position_[col] == kNone && std::fabs(work[col]) >= tolerance * pivot_abs) {
+                pivot_row = col;
+            }
+            if (pivot_row != col) {
+                stats::add(stats::Counter::RowSwaps);
+            }
+
+            const T pivot = work[pivot_row];
+            u_indices.push_back(step);
+            u_values.push_back(pivot);
+            u_offsets.push_back(u_indices.size());
+            row_position_[pivot_row] = step;
+
+            l_indices.push_back(pivot_row);
+            l_values.push_back(T(1));
+            for (const std::size_t row : pattern) {
+                if (row_position_[row] == kNone) {
+                    l_indices.push_back(row);
+                    l_values.push_back(work[row] / pivot);
+                }
+                work[row] = T(0);
+            }
+            l_offsets.push_back(l_indices.size());
+        }
+
+        permutation_sign_ = permutation_sign(row_position_) * permutation_sign(column_order_);
+
+        // U entries of a column are sorted by step with the diagonal last, L rows are renumbered
+        // into pivot order so both factors are proper CSC matrices
+        for (std::size_t col = 0; col < n; ++col) {
+            sort_column(u_offsets[col], u_offsets[col + 1], u_indices, u_values);
+        }
+        for (std::size_t& row : l_indices) {
+            row = row_position_[row];
+        }
+        for (std::size_t col = 0; col < n; ++col) {
+            sort_column(l_offsets[col], l_offsets[col + 1], l_indices, l_values);
+        }
+        lower_ = SparseMatrix<T, SparseFormat::Csc>(n, n, std::move(l_offsets), std::move(l_indices), std::move(l_values));
+        upper_ = SparseMatrix<T, SparseFormat::Csc>(n, n, std::move(u_offsets), std::move(u_indices), std::move(u_values));
+    }
+
+    static void sort_column(std::size_t first, std::size_t last, std::vector<std::size_t>& indices, std::vector<T>& values) {
+        std::vector<std::pair<std::size_t, T>> column;
+        column.reserve(last - first);
+        for (std::size_t pos = first; pos < last; ++pos) {
+            column.emplace_back(indices[pos], values[pos]);
+        }
+        std::sort(column.begin(), column.end(), [](const auto& left, const auto& right) { return left.first < right.first; });
+        for (std::size_t pos = first; pos < last; ++pos) {
+            indices[pos] = column[pos - first].first;
+            values[pos] = column[pos - first].second;
+        }
+    }
+
+    // +1 or -1 by the parity of the cycles
+    static int permutation_sign(const std::vector<std::size_t>& permutation) {
+        int sign = 1;
+        std::vector<char> seen(permutation.size(), 0);
+        for (std::size_t start = 0; start < permutation.size(); ++start) {
+            if (seen[start]) {
+                continue;
+            }
+            std::size_t length = 0;
+            for (std::size_t idx = start; !seen[idx]; idx = permutation[idx]) {
+                seen[idx] = 1;
+                ++length;
+            }
+            if (length % 2 == 0) {
+                sign = -sign;
+            }
+        }
+        return sign;
+    }
+
+  private: // fields
+    std::vector<std::size_t> column_order_{};
+    std::vector<std::size_t> row_position_{};
+    SparseMatrix<T, SparseFormat::Csc> lower_{};
+    SparseMatrix<T, SparseFormat::Csc> upper_{};
+    int permutation_sign_ = 1;
+    bool singular_ = false;
+};
+
+// determinant through the sparse LU, time and memory follow the non-zeros of the factors
+template <FloatingPoint T, SparseFormat Format>
+T determinant(const SparseMatrix<T, Format>& matrix) {
+    return SparseLU<T>(matrix.to_csc()).determinant();
+}
+
+} // namespace mtx
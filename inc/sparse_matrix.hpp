@@ -0,0 +1,251 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <iostream>
+#include <vector>
+
+#include "common.hpp"
+#include "matrix.hpp"
+#include "matrix_reader.hpp"
+
+namespace mtx {
+
+enum class SparseFormat {
+    Csr, // compressed rows: the outer dimension is rows, indices are columns
+    Csc, // compressed columns: the outer dimension is columns, indices are rows
+};
+
+template <FloatingPoint T>
+struct SparseEntry {
+    std::size_t row;
+    std::size_t col;
+    T value;
+};
+
+// Compressed sparse matrix: only non-zeros are stored, so memory is O(nnz + outer size).
+// Entries of outer line k are [offsets[k], offsets[k + 1]) in indices/values, sorted by index.
+template <FloatingPoint T, SparseFormat Format = SparseFormat::Csr>
+class SparseMatrix {
+  public:
+    static constexpr SparseFormat kFormat = Format;
+
+    SparseMatrix() : offsets_(1, 0) {}
+
+    SparseMatrix(std::size_t n_rows, std::size_t n_cols)
+        : n_rows_(n_rows), n_cols_(n_cols), offsets_(outer_size() + 1, 0) {}
+
+    // the compressed arrays as they are, indices must be sorted and unique inside every outer line
+    SparseMatrix(std::size_t n_rows, std::size_t n_cols, std::vector<std::size_t> offsets,
+                 std::vector<std::size_t> indices, std::vector<T> values)
+        : n_rows_(n_rows), n_cols_(n_cols), offsets_(std::move(offsets)),
+          indices_(std::move(indices)), values_(std::move(values))
+    {
+        assert(offsets_.size() == outer_size() + 1 && offsets_.front() == 0);
+        assert(offsets_.back() == indices_.size() && indices_.size() == values_.size());
+    }
+
+    // duplicates are summed, entries that end up zero are dropped
+    static SparseMatrix from_entries(std::size_t n_rows, std::size_t n_cols, std::vector<SparseEntry<T>> entries) {
+        auto key = [](const SparseEntry<T>& entry) {
+            return Format == SparseFormat::Csr ? std::pair(entry.row, entry.col) : std::pair(entry.col, entry.row);
+        };
+        std::sort(entries.begin(), entries.end(), [&](const auto& left, const auto& right) {
+            return key(left) < key(right);
+        });
+
+        SparseMatrix res(n_rows, n_cols);
+        res.indices_.reserve(entries.size());
+        res.values_.reserve(entries.size());
+        for (std::size_t idx = 0; idx < entries.size();) {
+            const auto [outer, inner] = key(entries[idx]);
+            assert(entries[idx].row < n_rows && entries[idx].col < n_cols);
+
+            T sum = T(0);
+            for (; idx < entries.size() && key(entries[idx]) == std::pair(outer, inner); ++idx) {
+                sum += entries[idx].value;
+            }
+            if (sum != T(0)) {
+                res.indices_.push_back(inner);
+                res.values_.push_back(sum);
+                ++res.offsets_[outer + 1];
+            }
+        }
+        for (std::size_t outer = 0; outer < res.outer_size(); ++outer) {
+            res.offsets_[outer + 1] += res.offsets_[outer];
+        }
+        return res;
+    }
+
+    // keeps every element that is not exactly zero, as from_entries does
+    template <typename Alloc>
+    explicit SparseMatrix(const Matrix<T, Alloc>& matrix) : SparseMatrix(matrix.n_rows(), matrix.n_cols()) {
+        for (std::size_t outer = 0; outer < outer_size(); ++outer) {
+            for (std::size_t inner = 0; inner < inner_size(); ++inner) {
+                const T value = Format == SparseFormat::Csr ? matrix[outer][inner] : matrix[inner][outer];
+                if (value != T(0)) {
+                    indices_.push_back(inner);
+                    values_.push_back(value);
+                }
+            }
+            offsets_[outer + 1] = indices_.size();
+        }
+    }
+
+  public: // getters
+    std::size_t n_rows() const { return n_rows_; }
+    std::size_t n_cols() const { return n_cols_; }
+    std::size_t nnz() const { return values_.size(); }
+
+    std::size_t outer_size() const { return Format == SparseFormat::Csr ? n_rows_ : n_cols_; }
+    std::size_t inner_size() const { return Format == SparseFormat::Csr ? n_cols_ : n_rows_; }
+
+    const std::vector<std::size_t>& offsets() const { return offsets_; }
+    const std::vector<std::size_t>& indices() const { return indices_; }
+    const std::vector<T>& values() const { return values_; }
+
+    // binary search inside the row (CSR) or column (CSC), zero for elements that are not stored
+    T at(std::size_t row, std::size_t col) const {
+        assert(row < n_rows_ && col < n_cols_);
+        const std::size_t outer = Format == SparseFormat::Csr ? row : col;
+        const std::size_t inner = Format == SparseFormat::Csr ? col : row;
+
+        const auto first = indices_.begin() + offsets_[outer];
+        const auto last = indices_.begin() + offsets_[outer + 1];
+        const auto found = std::lower_bound(first, last, inner);
+        if (found == last || *found != inner) {
+            return T(0);
+        }
+        return values_[found - indices_.begin()];
+    }
+
+  public: // conversions
+    // counting sort by the inner index, O(nnz + n_rows + n_cols)
+    template <SparseFormat Other>
+    SparseMatrix<T, Other> to_format() const {
+        if constexpr (Other == Format) {
+            return *this;
+        } else {
+            std::vector<std::size_t> offsets(inner_size() + 1, 0);
+            for (const std::size_t inner : indices_) {
+                ++offsets[inner + 1];
+            }
+            for (std::size_t inner = 0; inner < inner_size(); ++inner) {
+                offsets[inner + 1] += offsets[inner];
+            }
+
+            std::vector<std::size_t> indices(nnz());
+            std::vector<T> values(nnz());
+            std::vector<std::size_t> next(offsets.begin(), offsets.end() - 1);
+            for (std::size_t outer = 0; outer < outer_size(); ++outer) {
+                for (std::size_t pos = offsets_[outer]; pos < offsets_[outer + 1]; ++pos) {
+                    const std::size_t dst = next[indices_[pos]]++;
+                    indices[dst] = outer;
+                    values[dst] = values_[pos];
+                }
+            }
+            return SparseMatrix<T, Other>(n_rows_, n_cols_, std::move(offsets), std::move(indices), std::move(values));
+        }
+    }
+
+    SparseMatrix<T, SparseFormat::Csr> to_csr() const { return to_format<SparseFormat::Csr>(); }
+    SparseMatrix<T, SparseFormat::Csc> to_csc() const { return to_format<SparseFormat::Csc>(); }
+
+    Matrix<T> to_matrix() const {
+        Matrix<T> res(n_rows_, n_cols_);
+        for (std::size_t outer = 0; outer < outer_size(); ++outer) {
+            for (std::size_t pos = offsets_[outer]; pos < offsets_[outer + 1]; ++pos) {
+                if constexpr (Format == SparseFormat::Csr) {
+                    res[outer][indices_[pos]] = values_[pos];
+                } else {
+                    res[indices_[pos]][outer] = values_[pos];
+                }
+            }
+        }
+        return res;
+    }
+
+  private:
+    std::size_t n_rows_ = 0;
+    std::size_t n_cols_ = 0;
+    std::vector<std::size_t> offsets_{};
+    std::vector<std::size_t> indices_{};
+    std::vector<T> values_{};
+};
+
+// ------------------------------------ text input ---------------------------------------------------
+
+// The dense text format (size, then size rows of size numbers) read one row at a time:
+// only the non-zeros are kept, so memory is O(nnz + size) instead of O(size^2).
+template <FloatingPoint T>
+bool read_sparse_text(MatrixReader& reader, SparseMatrix<T>& matrix) {
+    std::size_t size = 0;
+    if (!reader.scan_until_next_line(size)) {
+        return false;
+    }
+
+    std::vector<std::size_t> offsets(1, 0);
+    std::vector<std::size_t> indices;
+    std::vector<T> values;
+    offsets.reserve(size + 1);
+
+    std::vector<T> row(size);
+    for (std::size_t i = 0; i < size; i++) {
+        if (reader.read_values(row.data(), size) != size) {
+            return false;
+        }
+        for (std::size_t j = 0; j < size; j++) {
+            if (row[j] != T(0)) {
+                indices.push_back(j);
+                values.push_back(row[j]);
+            }
+        }
+        offsets.push_back(indices.size());
+    }
+
+    matrix = SparseMatrix<T>(size, size, std::move(offsets), std::move(indices), std::move(values));
+    return true;
+}
+
+// Coordinate text format: "size nnz", then nnz lines "row col value" with 0-based indices,
+// read time is O(nnz) as well. Duplicates are summed, but nnz may not exceed size * size.
+template <FloatingPoint T>
+bool read_coordinate_text(MatrixReader& reader, SparseMatrix<T>& matrix) {
+    // the header is untrusted, memory grows with the entries actually read
+    constexpr std::size_t kMaxReservedEntries = std::size_t(1) << 20;
+
+    std::size_t size = 0;
+    std::size_t nnz = 0;
+    if (!reader.scan_until_next_line(size) || !reader.scan_until_next_line(nnz)) {
+        return false;
+    }
+    // nnz <= size * size without computing the product
+    if (size == 0 ? nnz != 0 : nnz / size + (nnz % size != 0) > size) {
+        return false;
+    }
+
+    std::vector<SparseEntry<T>> entries;
+    entries.reserve(std::min(nnz, kMaxReservedEntries));
+    for (std::size_t idx = 0; idx < nnz; ++idx) {
+        SparseEntry<T> entry{};
+        if (!reader.scan_until_next_line(entry.row) || !reader.scan_until_next_line(entry.col) ||
+            !reader.scan_until_next_line(entry.value)) {
+            return false;
+        }
+        if (entry.row >= size || entry.col >= size) {
+            return false;
+        }
+        entries.push_back(entry);
+    }
+
+    matrix = SparseMatrix<T>::from_entries(size, size, std::move(entries));
+    return true;
+}
+
+template <FloatingPoint T, SparseFormat Format>
+std::ostream& operator<<(std::ostream& ostream, const SparseMatrix<T, Format>& matrix) {
+    return ostream << matrix.to_matrix();
+}
+
+} // namespace mtx
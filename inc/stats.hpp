@@ -0,0 +1,148 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+// Optional instrumentation: counters (allocations, pivot searches, row swaps, flops)
+// and phase timers (parse, copy, factor, reduce, waiting for out-of-core I/O).
+// It is compiled in only when MTX_ENABLE_STATS is defined (cmake -DMTX_ENABLE_STATS=ON),
+// otherwise every hook is an empty inline function and costs nothing.
+
+namespace mtx::stats {
+
+#ifdef MTX_ENABLE_STATS
+inline constexpr bool kEnabled = true;
+#else
+inline constexpr bool kEnabled = false;
+#endif
+
+enum class Counter {
+    Allocations,
+    AllocatedBytes,
+    PivotSearches,
+    RowSwaps,
+    Flops,
+    kCount,
+};
+
+enum class Phase {
+    Parse,
+    Copy,
+    Factor,
+    Reduce,
+    IoWait,
+    kCount,
+};
+
+struct Stats {
+    std::uint64_t allocations = 0;
+    std::uint64_t allocated_bytes = 0;
+    std::uint64_t pivot_searches = 0;
+    std::uint64_t row_swaps = 0;
+    std::uint64_t flops = 0;
+
+    double parse_seconds = 0;
+    double copy_seconds = 0;
+    double factor_seconds = 0;
+    double reduce_seconds = 0;
+    double io_wait_seconds = 0;
+};
+
+namespace detail {
+
+inline std::atomic<std::uint64_t> counters[static_cast<std::size_t>(Counter::kCount)]{};
+inline std::atomic<std::uint64_t> phase_nanoseconds[static_cast<std::size_t>(Phase::kCount)]{};
+
+inline double seconds(Phase phase) {
+    return double(phase_nanoseconds[static_cast<std::size_t>(phase)].load(std::memory_order_relaxed)) * 1e-9;
+}
+
+} // namespace detail
+
+// counters are shared by all threads, updates are relaxed atomic additions
+inline void add(Counter counter, std::uint64_t value = 1) {
+    if constexpr (kEnabled) {
+        detail::counters[static_cast<std::size_t>(counter)].fetch_add(value, std::memory_order_relaxed);
+    }
+}
+
+// adds the lifetime of the object to the phase, an empty object when disabled
+#ifdef MTX_ENABLE_STATS
+class ScopedTimer {
+  public:
+    explicit ScopedTimer(Phase phase) : phase_(phase), start_(std::chrono::steady_clock::now()) {}
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    ~ScopedTimer() {
+        const auto elapsed = std::chrono::steady_clock::now() - start_;
+        const auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+        detail::phase_nanoseconds[static_cast<std::size_t>(phase_)].fetch_add(
+            static_cast<std::uint64_t>(nanoseconds), std::memory_order_relaxed);
+    }
+
+  private:
+    Phase phase_;
+    std::chrono::steady_clock::time_point start_;
+};
+#else
+class ScopedTimer {
+  public:
+    explicit ScopedTimer(Phase) {}
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+};
+#endif
+
+// everything recorded since the start of the program or the last reset(), all zeros when disabled
+inline Stats snapshot() {
+    Stats res;
+    if constexpr (kEnabled) {
+        auto count = [](Counter counter) {
+            return detail::counters[static_cast<std::size_t>(counter)].load(std::memory_order_relaxed);
+        };
+        res.allocations = count(Counter::Allocations);
+        res.allocated_bytes = count(Counter::AllocatedBytes);
+        res.pivot_searches = count(Counter::PivotSearches);
+        res.row_swaps = count(Counter::RowSwaps);
+        res.flops = count(Counter::Flops);
+
+        res.parse_seconds = detail::seconds(Phase::Parse);
+        res.copy_seconds = detail::seconds(Phase::Copy);
+        res.factor_seconds = detail::seconds(Phase::Factor);
+        res.reduce_seconds = detail::seconds(Phase::Reduce);
+        res.io_wait_seconds = detail::seconds(Phase::IoWait);
+    }
+    return res;
+}
+
+inline void reset() {
+    if constexpr (kEnabled) {
+        for (auto& counter : detail::counters) {
+            counter.store(0, std::memory_order_relaxed);
+        }
+        for (auto& phase : detail::phase_nanoseconds) {
+            phase.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+inline std::ostream& operator<<(std::ostream& ostream, const Stats& stats) {
+    ostream << "allocations:     " << stats.allocations << " (" << stats.allocated_bytes << " bytes)\n"
+            << "pivot searches:  " << stats.pivot_searches << "\n"
+            << "row swaps:       " << stats.row_swaps << "\n"
+            << "flops:           " << stats.flops << "\n"
+            << "parse seconds:   " << stats.parse_seconds << "\n"
+            << "copy seconds:    " << stats.copy_seconds << "\n"
+            << "factor seconds:  " << stats.factor_seconds << "\n"
+            << "reduce seconds:  " << stats.reduce_seconds << "\n"
+            << "io wait seconds: " << stats.io_wait_seconds << "\n";
+    return ostream;
+}
+
+} // namespace mtx::stats
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include "thread_pool.hpp"
+
+namespace mtx {
+
+// Work-stealing execution of a task graph that unfolds while it runs: a task spawns its successors
+// once their dependencies are met, the graph itself lives in the caller's counters.
+// Every worker owns a deque, runs its own newest task first (the data it just wrote is still in
+// cache) and steals the oldest task of another worker when it runs dry. Urgent tasks (the critical
+// path) go to a shared queue that every worker checks first.
+// The workers are the threads of a ThreadPool, so no threads are created per graph.
+class TaskScheduler {
+  public:
+    using Task = std::function<void()>;
+
+    explicit TaskScheduler(std::size_t n_workers) : n_workers_(std::max<std::size_t>(n_workers, 1)),
+                                                    queues_(std::make_unique<Queue[]>(n_workers_ + 1)) {}
+
+    TaskScheduler(const TaskScheduler&) = delete;
+    TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+  public:
+    std::size_t n_workers() const { return n_workers_; }
+
+    // from the outside before run() or from a running task
+    void spawn(Task task, bool urgent = false) {
+        pending_.fetch_add(1, std::memory_order_relaxed);
+        Queue& queue = urgent || current_worker_ == kNoWorker ? queues_[n_workers_] : queues_[current_worker_];
+        std::lock_guard lock(queue.mutex);
+        queue.tasks.push_back(std::move(task));
+    }
+
+    // returns when every spawned task, including the ones spawned meanwhile, is done;
+    // the pool must have at least n_workers() threads, without a pool one worker runs inline
+    void run(ThreadPool* pool) {
+        if (pool == nullptr || n_workers_ == 1) {
+            work(0);
+            return;
+        }
+        pool->parallel_for(0, n_workers_, 1, [this](std::size_t begin, std::size_t end) {
+            for (std::size_t worker = begin; worker < end; ++worker) {
+                work(worker);
+            }
+        });
+    }
+
+  private:
+    static constexpr std::size_t kNoWorker = static_cast<std::size_t>(-1);
+
+    struct alignas(64) Queue {
+        std::mutex mutex{};
+        std::deque<Task> tasks{};
+    };
+
+    void work(std::size_t worker) {
+        current_worker_ = worker;
+        while (pending_.load(std::memory_order_acquire) > 0) {
+            Task task;
+            if (pop(worker, task)) {
+                task();
+                pending_.fetch_sub(1, std::memory_order_acq_rel);
+            } else {
+                std::this_thread::yield();
+            }
+        }
+        current_worker_ = kNoWorker;
+    }
+
+    // the urgent queue first, then the newest own task, then the oldest task of someone else
+    bool pop(std::size_t worker, Task& task) {
+        if (take(queues_[n_workers_], task, false) || take(queues_[worker], task, true)) {
+            return true;
+        }
+        for (std::size_t shift = 1; shift < n_workers_; ++shift) {
+            if (take(queues_[(worker + shift) % n_workers_], task, false)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static bool take(Queue& queue, Task& task, bool newest) {
+        std::lock_guard lock(queue.mutex);
+        if (queue.tasks.empty()) {
+            return false;
+        }
+        if (newest) {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+        } else {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+        }
+        return true;
+    }
+
+  private:
+    std::size_t n_workers_ = 1;
+    // one per worker, the last one holds urgent tasks and the ones spawned from outside
+    std::unique_ptr<Queue[]> queues_{};
+    std::atomic<std::size_t> pending_{0};
+
+    static inline thread_local std::size_t current_worker_ = kNoWorker;
+};
+
+} // namespace mtx
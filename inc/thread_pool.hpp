@@ -0,0 +1,128 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace mtx {
+
+// fixed set of worker threads for data-parallel loops,
+// the calling thread takes part in every loop, so ThreadPool(1) runs everything inline;
+// loops must not be nested or issued from several threads at once
+class ThreadPool {
+  public:
+    explicit ThreadPool(std::size_t n_threads = default_n_threads()) {
+        n_threads = std::max<std::size_t>(n_threads, 1);
+        workers_.reserve(n_threads - 1);
+        for (std::size_t idx = 0; idx + 1 < n_threads; ++idx) {
+            workers_.emplace_back([this] { worker_loop(); });
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    ~ThreadPool() {
+        {
+            std::lock_guard lock(mutex_);
+            stopping_ = true;
+        }
+        job_ready_.notify_all();
+        for (std::thread& worker : workers_) {
+            worker.join();
+        }
+    }
+
+  public:
+    std::size_t n_threads() const { return workers_.size() + 1; }
+
+    static std::size_t default_n_threads() {
+        return std::max<unsigned>(std::thread::hardware_concurrency(), 1);
+    }
+
+  public:
+    // calls func(chunk_begin, chunk_end) for chunks of [begin, end) no smaller than grain,
+    // chunks are handed out dynamically, returns when all of them are done
+    template <typename Func>
+    void parallel_for(std::size_t begin, std::size_t end, std::size_t grain, Func&& func) {
+        if (begin >= end) {
+            return;
+        }
+        grain = std::max<std::size_t>(grain, 1);
+        if (workers_.empty() || end - begin <= grain) {
+            func(begin, end);
+            return;
+        }
+
+        std::unique_lock lock(mutex_);
+        job_ = [&func](std::size_t chunk_begin, std::size_t chunk_end) { func(chunk_begin, chunk_end); };
+        job_end_ = end;
+        job_grain_ = std::max(grain, (end - begin) / (n_threads() * kChunksPerThread));
+        next_.store(begin);
+        busy_workers_ = workers_.size();
+        ++generation_;
+        lock.unlock();
+        job_ready_.notify_all();
+
+        run_chunks();
+
+        lock.lock();
+        job_done_.wait(lock, [this] { return busy_workers_ == 0; });
+        job_ = nullptr;
+    }
+
+  private:
+    static constexpr std::size_t kChunksPerThread = 4;
+
+    void run_chunks() {
+        while (true) {
+            const std::size_t chunk_begin = next_.fetch_add(job_grain_);
+            if (chunk_begin >= job_end_) {
+                return;
+            }
+            job_(chunk_begin, std::min(chunk_begin + job_grain_, job_end_));
+        }
+    }
+
+    void worker_loop() {
+        std::size_t seen_generation = 0;
+        while (true) {
+            std::unique_lock lock(mutex_);
+            job_ready_.wait(lock, [&] { return stopping_ || generation_ != seen_generation; });
+            if (stopping_) {
+                return;
+            }
+            seen_generation = generation_;
+            lock.unlock();
+
+            run_chunks();
+
+            lock.lock();
+            if (--busy_workers_ == 0) {
+                job_done_.notify_one();
+            }
+        }
+    }
+
+  private:
+    std::vector<std::thread> workers_{};
+
+    std::mutex mutex_{};
+    std::condition_variable job_ready_{};
+    std::condition_variable job_done_{};
+    bool stopping_ = false;
+    std::size_t generation_ = 0;
+    std::size_t busy_workers_ = 0;
+
+    std::function<void(std::size_t, std::size_t)> job_{};
+    std::size_t job_end_ = 0;
+    std::size_t job_grain_ = 1;
+    std::atomic<std::size_t> next_{0};
+};
+
+} // namespace mtx
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <utility>
+
+namespace mtx::kernels {
+
+namespace detail {
+
+// below this many rows and columns a block fits in L1 and is handled by plain loops
+inline constexpr std::size_t kTransposeLeaf = 32;
+
+} // namespace detail
+
+// B = A^T for row-major m x n A and n x m B, which must not overlap.
+// Cache-oblivious: the longer side is halved until a block fits in cache.
+template <typename T>
+void transpose(std::size_t m, std::size_t n, const T* a, std::size_t lda, T* b, std::size_t ldb) {
+    if (m <= detail::kTransposeLeaf && n <= detail::kTransposeLeaf) {
+        for (std::size_t row = 0; row < m; ++row) {
+            for (std::size_t col = 0; col < n; ++col) {
+                b[col * ldb + row] = a[row * lda + col];
+            }
+        }
+        return;
+    }
+
+    if (m >= n) {
+        const std::size_t half = m / 2;
+        transpose(half, n, a, lda, b, ldb);
+        transpose(m - half, n, a + half * lda, lda, b + half, ldb);
+    } else {
+        const std::size_t half = n / 2;
+        transpose(m, half, a, lda, b, ldb);
+        transpose(m, n - half, a + half, lda, b + half * ldb, ldb);
+    }
+}
+
+// swaps the m x n block A with the n x m block B transposed: A <-> B^T
+template <typename T>
+void transpose_swap(std::size_t m, std::size_t n, T* a, std::size_t lda, T* b, std::size_t ldb) {
+    if (m <= detail::kTransposeLeaf && n <= detail::kTransposeLeaf) {
+        for (std::size_t row = 0; row < m; ++row) {
+            for (std::size_t col = 0; col < n; ++col) {
+                std::swap(a[row * lda + col], b[col * ldb + row]);
+            }
+        }
+        return;
+    }
+
+    if (m >= n) {
+        const std::size_t half = m / 2;
+        transpose_swap(half, n, a, lda, b, ldb);
+        transpose_swap(m - half, n, a + half * lda, lda, b + half, ldb);
+    } else {
+        const std::size_t half = n / 2;
+        transpose_swap(m, half, a, lda, b, ldb);
+        transpose_swap(m, n - half, a + half, lda, b + half * ldb, ldb);
+    }
+}
+
+// A = A^T for a square n x n block without extra memory:
+// diagonal quadrants are transposed recursively, off-diagonal ones are swapped with each other
+template <typename T>
+void transpose_inplace(std::size_t n, T* a, std::size_t lda) {
+    if (n <= detail::kTransposeLeaf) {
+        for (std::size_t row = 0; row < n; ++row) {
+            for (std::size_t col = row + 1; col < n; ++col) {
+                std::swap(a[row * lda + col], a[col * lda + row]);
+            }
+        }
+        return;
+    }
+
+    const std::size_t half = n / 2;
+    transpose_inplace(half, a, lda);
+    transpose_inplace(n - half, a + half * lda + half, lda);
+    transpose_swap(half, n - half, a + half, lda, a + half * lda, lda);
+}
+
+} // namespace mtx::kernels
@@ -1,26 +1,235 @@
+#include <fstream>
 #include <istream>
 #include <sstream>
 #include <iostream>
+#include <optional>
+#include <string>
 #include <vector>
 
+#include <binary_io.hpp>
 #include <matrix.hpp>
+#include <matrix_reader.hpp>
+#include <mixed_precision.hpp>
+#include <out_of_core.hpp>
+#include <sparse_lu.hpp>
+#include <sparse_matrix.hpp>
+#include <stats.hpp>
+
+template <typename T>
+static std::optional<mtx::Matrix<T>> read_text_matrix(std::istream& stream) {
+    mtx::MatrixReader reader(stream);
 
-int main () {
     std::size_t size = 0;
-    if (!scan_until_next_line(std::cin, size)) {
+    if (!reader.scan_until_next_line(size)) {
         std::cerr << "failed to scan size\n";
-        return 1;
+        return std::nullopt;
     }
 
-    mtx::Matrix<double> matrix(size);
+    // every element is parsed into place, zeroing the storage first would only add a pass over memory
+    mtx::Matrix<T> matrix(size, size, mtx::kUninitialized);
     for (std::size_t i = 0; i < size; i++) {
-        for (std::size_t j = 0; j < size; j++) {
-            if (!scan_until_next_line(std::cin, matrix[i][j])) {
-                std::cerr << "failed to scan matrix[" << i << "][" << j << "]\n"; 
+        std::size_t n_read = reader.read_values(matrix.data().row_begin(i), size);
+        if (n_read != size) {
+            std::cerr << "failed to scan matrix[" << i << "][" << n_read << "]\n";
+            return std::nullopt;
+        }
+    }
+
+    return matrix;
+}
+
+// integer entries, the determinant is exact as long as it fits into long long
+static std::optional<long long> integer_determinant(const std::string& input_path, std::size_t n_threads) {
+    std::optional<mtx::Matrix<long long>> matrix;
+    {
+        mtx::stats::ScopedTimer timer(mtx::stats::Phase::Parse);
+        if (input_path.empty()) {
+            matrix = read_text_matrix<long long>(std::cin);
+        } else {
+            std::ifstream file(input_path);
+            if (!file) {
+                std::cerr << "failed to open " << input_path << "\n";
+                return std::nullopt;
+            }
+            matrix = read_text_matrix<long long>(file);
+        }
+    }
+    if (!matrix) {
+        return std::nullopt;
+    }
+    return matrix->determinant(n_threads);
+}
+
+// same text format, but only the non-zeros are stored and eliminated
+static std::optional<double> sparse_determinant(const std::string& input_path) {
+    std::ifstream file;
+    if (!input_path.empty()) {
+        file.open(input_path);
+        if (!file) {
+            std::cerr << "failed to open " << input_path << "\n";
+            return std::nullopt;
+        }
+    }
+
+    mtx::SparseMatrix<double> matrix;
+    {
+        mtx::stats::ScopedTimer timer(mtx::stats::Phase::Parse);
+        mtx::MatrixReader reader(input_path.empty() ? std::cin : file);
+        if (!mtx::read_sparse_text(reader, matrix)) {
+            std::cerr << "failed to scan sparse matrix\n";
+            return std::nullopt;
+        }
+    }
+    return mtx::determinant(matrix);
+}
+
+// the binary file is streamed panel by panel, memory use stays within budget bytes
+static std::optional<double> out_of_core_determinant(const std::string& input_path, std::size_t budget,
+                                                     std::size_t n_threads) {
+    if (input_path.empty() || !mtx::is_binary_matrix_file(input_path)) {
+        std::cerr << "out-of-core mode needs a binary --input file, convert with --save-binary\n";
+        return std::nullopt;
+    }
+
+    mtx::MappedMatrix<double> mapped;
+    if (!mapped.map(input_path)) {
+        std::cerr << "failed to map binary matrix " << input_path << "\n";
+        return std::nullopt;
+    }
+
+    mtx::OutOfCoreLU<double> lu(budget, mtx::OutOfCoreLU<double>::default_scratch_dir(), n_threads);
+    if (!lu.factorize(mapped)) {
+        std::cerr << "out-of-core factorization failed: non-square matrix, too small budget or scratch write error\n";
+        return std::nullopt;
+    }
+    return lu.determinant();
+}
+
+static std::optional<mtx::Matrix<double>> read_matrix(const std::string& input_path) {
+    mtx::stats::ScopedTimer timer(mtx::stats::Phase::Parse);
+    if (input_path.empty()) {
+        return read_text_matrix<double>(std::cin);
+    }
+
+    if (mtx::is_binary_matrix_file(input_path)) {
+        mtx::MappedMatrix<double> mapped;
+        if (!mapped.map(input_path)) {
+            std::cerr << "failed to map binary matrix " << input_path << "\n";
+            return std::nullopt;
+        }
+        if (mapped.n_rows() != mapped.n_cols()) {
+            std::cerr << "matrix is not square\n";
+            return std::nullopt;
+        }
+        return mapped.to_matrix();
+    }
+
+    std::ifstream file(input_path);
+    if (!file) {
+        std::cerr << "failed to open " << input_path << "\n";
+        return std::nullopt;
+    }
+    return read_text_matrix<double>(file);
+}
+
+int main (int argc, char** argv) {
+    std::size_t n_threads = 1;
+    std::string input_path;
+    std::string binary_output_path;
+    bool print_stats = false;
+    bool sparse = false;
+    bool integer = false;
+    bool mixed = false;
+    std::size_t out_of_core_budget = 0;
+    for (int arg_idx = 1; arg_idx < argc; arg_idx++) {
+        std::string arg = argv[arg_idx];
+        if (arg == "--threads" && arg_idx + 1 < argc) {
+            std::istringstream thread_stream(argv[++arg_idx]);
+            if (!(thread_stream >> n_threads)) {
+                std::cerr << "failed to parse thread count\n";
+                return 1;
+            }
+        } else if (arg == "--input" && arg_idx + 1 < argc) {
+            input_path = argv[++arg_idx];
+        } else if (arg == "--save-binary" && arg_idx + 1 < argc) {
+            binary_output_path = argv[++arg_idx];
+        } else if (arg == "--out-of-core" && arg_idx + 1 < argc) {
+            std::istringstream budget_stream(argv[++arg_idx]);
+            std::size_t budget_mb = 0;
+            if (!(budget_stream >> budget_mb) || budget_mb == 0) {
+                std::cerr << "failed to parse memory budget\n";
                 return 1;
             }
+            out_of_core_budget = budget_mb << 20;
+        } else if (arg == "--mixed") {
+            mixed = true;
+        } else if (arg == "--integer") {
+            integer = true;
+        } else if (arg == "--sparse") {
+            sparse = true;
+        } else if (arg == "--stats") {
+            print_stats = true;
+        } else {
+            std::cerr << "usage: " << argv[0] << " [--threads N] [--input FILE] [--save-binary FILE] [--sparse | --integer | --mixed | --out-of-core MB] [--stats]\n";
+            return 1;
+        }
+    }
+
+    const bool out_of_core = out_of_core_budget > 0;
+    if (int(sparse) + int(integer) + int(mixed) + int(out_of_core) > 1) {
+        std::cerr << "--sparse, --integer, --mixed and --out-of-core exclude each other\n";
+        return 1;
+    }
+    // the binary format holds dense float or double matrices, the out-of-core input already is one
+    if (!binary_output_path.empty() && (sparse || integer || out_of_core)) {
+        std::cerr << "--save-binary works only with the dense and --mixed modes\n";
+        return 1;
+    }
+
+    std::ios::sync_with_stdio(false);
+
+    if (out_of_core) {
+        std::optional<double> determinant = out_of_core_determinant(input_path, out_of_core_budget, n_threads);
+        if (!determinant) {
+            return 1;
+        }
+        std::cout << *determinant;
+    } else if (integer) {
+        std::optional<long long> determinant = integer_determinant(input_path, n_threads);
+        if (!determinant) {
+            return 1;
+        }
+        std::cout << *determinant;
+    } else if (sparse) {
+        std::optional<double> determinant = sparse_determinant(input_path);
+        if (!determinant) {
+            return 1;
+        }
+        std::cout << *determinant;
+    } else {
+        std::optional<mtx::Matrix<double>> matrix = read_matrix(input_path);
+        if (!matrix) {
+            return 1;
+        }
+
+        if (!binary_output_path.empty() && !mtx::write_binary(*matrix, binary_output_path)) {
+            std::cerr << "failed to write " << binary_output_path << "\n";
+            return 1;
+        }
+
+        if (mixed) {
+            std::cout << mtx::mixed_precision_determinant(*matrix, n_threads);
+        } else {
+            std::cout << std::move(*matrix).lu(mtx::LU<double>::kDefaultBlockSize, n_threads).determinant();
         }
     }
 
-    std::cout << matrix.determinant();
+    // stderr, so the determinant on stdout stays machine-readable
+    if (print_stats) {
+        if (!mtx::stats::kEnabled) {
+            std::cerr << "\nstats are not compiled in, rebuild with -DMTX_ENABLE_STATS=ON\n";
+        } else {
+            std::cerr << "\n" << mtx::stats::snapshot();
+        }
+    }
 }
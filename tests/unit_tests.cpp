@@ -2,8 +2,26 @@
 #include <vector>
 #include <list>
 #include <string>
+#include <sstream>
+#include <fstream>
+#include <cstdio>
+#include <cstdint>
+#include <atomic>
+#include <functional>
 
 #include "jagged_array.hpp"
+#include "dense_array.hpp"
+#include "matrix.hpp"
+#include "fixed_matrix.hpp"
+#include "matrix_reader.hpp"
+#include "mixed_precision.hpp"
+#include "out_of_core.hpp"
+#include "binary_io.hpp"
+#include "batched.hpp"
+#include "sparse_lu.hpp"
+#include "sparse_matrix.hpp"
+#include "stats.hpp"
+#include "task_scheduler.hpp"
 
 using namespace mtx;
 
@@ -106,6 +124,70 @@ TEST(Array, resize)
     EXPECT_EQ(arr[1], 2);
 }
 
+TEST(Array, capacity)
+{
+    Array<int> arr;
+    std::size_t n_reallocations = 0;
+    for (int i = 0; i < 1000; i++) {
+        const std::size_t old_capacity = arr.capacity();
+        arr.resize(arr.size() + 1, i);
+        n_reallocations += arr.capacity() != old_capacity;
+    }
+    EXPECT_EQ(arr.size(), 1000);
+    EXPECT_EQ(arr[999], 999);
+    EXPECT_LE(n_reallocations, 11);
+
+    arr.resize(10);
+    EXPECT_GE(arr.capacity(), 1000);
+    arr.shrink_to_fit();
+    EXPECT_EQ(arr.capacity(), 10);
+    EXPECT_EQ(arr[9], 9);
+
+    arr.reserve(50);
+    EXPECT_EQ(arr.capacity(), 50);
+    EXPECT_EQ(arr.size(), 10);
+
+    // the fill value may live inside the array being grown
+    arr.resize(200, arr[3]);
+    EXPECT_EQ(arr[199], 3);
+}
+
+TEST(Array, axpy)
+{
+    Array<double> dst{1, 1, 1, 1};
+    Array<double> src{1, 2, 3, 4};
+    dst.axpy(2.0, src, 1, 3);
+    EXPECT_DOUBLE_EQ(dst[0], 1);
+    EXPECT_DOUBLE_EQ(dst[1], 5);
+    EXPECT_DOUBLE_EQ(dst[2], 7);
+    EXPECT_DOUBLE_EQ(dst[3], 1);
+
+    dst.axpy(-1.0, dst);
+    EXPECT_DOUBLE_EQ(dst[1], 0);
+}
+
+TEST(Array, lazy_expression)
+{
+    Array<double> a{1, 2, 3};
+    Array<double> b{4, 5, 6};
+    Array<double> c{1, 1, 1};
+
+    Array<double> res = a + b * 2.0 - c;
+    EXPECT_DOUBLE_EQ(res[0], 8);
+    EXPECT_DOUBLE_EQ(res[2], 14);
+
+    // the destination may appear in its own expression
+    a = 0.5 * (a + a) - b;
+    EXPECT_DOUBLE_EQ(a[0], -3);
+    EXPECT_DOUBLE_EQ(a[1], -3);
+    EXPECT_DOUBLE_EQ(a[2], -3);
+
+    Array<double> empty;
+    empty = b - c;
+    EXPECT_EQ(empty.size(), 3);
+    EXPECT_DOUBLE_EQ(empty[2], 5);
+}
+
 TEST(Array, fill)
 {
     Array<int> arr(3);
@@ -312,6 +394,16 @@ TEST(RectangularArray, swap_rows)
     EXPECT_EQ(rarr[2][1], 2);
 }
 
+TEST(RectangularArray, axpy_rows)
+{
+    RectangularArray<double> rarr{{1, 2, 3}, {4, 5, 6}};
+    rarr.axpy_rows(1, 0, -4.0, 1);
+    EXPECT_DOUBLE_EQ(rarr[1][0], 4);
+    EXPECT_DOUBLE_EQ(rarr[1][1], -3);
+    EXPECT_DOUBLE_EQ(rarr[1][2], -6);
+    EXPECT_DOUBLE_EQ(rarr[0][2], 3);
+}
+
 TEST(RectangularArray, resize)
 {
     RectangularArray<int> rarr{{1, 2}, {3, 4}};
@@ -320,6 +412,20 @@ TEST(RectangularArray, resize)
     EXPECT_EQ(rarr.n_cols(), 2);
 }
 
+TEST(RectangularArray, grow_row_by_row_moves_rows)
+{
+    RectangularArray<int> rarr(1, 4, 5);
+    const int* first_row = rarr[0].begin();
+    for (std::size_t i = 1; i < 100; i++) {
+        rarr.resize(i + 1, int(i));
+    }
+    EXPECT_EQ(rarr.n_rows(), 100);
+    EXPECT_EQ(rarr[99][3], 99);
+    // rows are moved on reallocation, their buffers are not copied
+    EXPECT_EQ(rarr[0].begin(), first_row);
+    EXPECT_EQ(rarr[0][3], 5);
+}
+
 TEST(RectangularArray, resize_rows)
 {
     RectangularArray<int> rarr{{1, 2}, {3, 4}};
@@ -328,6 +434,1269 @@ TEST(RectangularArray, resize_rows)
     EXPECT_EQ(rarr.n_cols(), 3);
 }
 
+// -----------------------------------------------------------------------------
+// --------------------------- DenseArray constructors -------------------------
+// -----------------------------------------------------------------------------
+
+TEST(DenseArray, initializer_list_constructor)
+{
+    DenseArray<double> darr{{1, 2, 3}, {4, 5, 6}};
+    EXPECT_EQ(darr.n_rows(), 2);
+    EXPECT_EQ(darr.n_cols(), 3);
+    EXPECT_DOUBLE_EQ(darr[0][0], 1);
+    EXPECT_DOUBLE_EQ(darr[1][2], 6);
+}
+
+TEST(DenseArray, padded_leading_dim)
+{
+    DenseArray<double> darr(3, 5, 1.0);
+    EXPECT_EQ(darr.leading_dim() % (DenseArray<double>::kAlignment / sizeof(double)), 0);
+    EXPECT_GE(darr.leading_dim(), darr.n_cols());
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(darr.row_begin(1)) % DenseArray<double>::kAlignment, 0);
+    EXPECT_EQ(darr.row_begin(2) - darr.row_begin(1), darr.leading_dim());
+}
+
+TEST(DenseArray, explicit_leading_dim)
+{
+    DenseArray<int> darr(2, 3, LeadingDim{7}, 4);
+    EXPECT_EQ(darr.leading_dim(), 7);
+    EXPECT_EQ(darr[1][2], 4);
+    EXPECT_EQ(darr.row_begin(1) - darr.data(), 7);
+}
+
+// -----------------------------------------------------------------------------
+// ----------------------------- DenseArray methods ----------------------------
+// -----------------------------------------------------------------------------
+
+TEST(DenseArray, row_view)
+{
+    DenseArray<int> darr{{1, 2}, {3, 4}};
+    RowView<int> row = darr[1];
+    EXPECT_EQ(row.size(), 2);
+    row[0] = 30;
+    EXPECT_EQ(darr[1][0], 30);
+
+    row += darr[0];
+    EXPECT_EQ(darr[1][0], 31);
+    EXPECT_EQ(darr[1][1], 6);
+}
+
+TEST(DenseArray, axpy_rows)
+{
+    DenseArray<double> darr{{1, 2, 3}, {4, 5, 6}};
+    darr.axpy_rows(1, 0, 2.0);
+    EXPECT_DOUBLE_EQ(darr[1][0], 6);
+    EXPECT_DOUBLE_EQ(darr[1][2], 12);
+
+    darr.axpy_rows(0, 0, 1.0, 2);
+    EXPECT_DOUBLE_EQ(darr[0][1], 2);
+    EXPECT_DOUBLE_EQ(darr[0][2], 6);
+}
+
+TEST(DenseArray, swap_rows)
+{
+    DenseArray<int> darr{{1, 2}, {3, 4}, {5, 6}};
+    darr.swap_rows(0, 2);
+    EXPECT_EQ(darr[0][0], 5);
+    EXPECT_EQ(darr[0][1], 6);
+    EXPECT_EQ(darr[2][0], 1);
+    EXPECT_EQ(darr[2][1], 2);
+}
+
+TEST(DenseArray, resize)
+{
+    DenseArray<int> darr{{1, 2}, {3, 4}};
+    darr.resize(3, 3, 9);
+    EXPECT_EQ(darr.n_rows(), 3);
+    EXPECT_EQ(darr.n_cols(), 3);
+    EXPECT_EQ(darr[1][1], 4);
+    EXPECT_EQ(darr[1][2], 9);
+    EXPECT_EQ(darr[2][0], 9);
+
+    darr.resize(1, 1);
+    EXPECT_EQ(darr[0][0], 1);
+}
+
+TEST(DenseArray, row_capacity)
+{
+    DenseArray<int> darr(0, 3);
+    std::size_t n_reallocations = 0;
+    for (int i = 0; i < 1000; i++) {
+        const std::size_t old_capacity = darr.row_capacity();
+        darr.resize(darr.n_rows() + 1, 3, i);
+        n_reallocations += darr.row_capacity() != old_capacity;
+    }
+    EXPECT_EQ(darr.n_rows(), 1000);
+    EXPECT_EQ(darr[0][2], 0);
+    EXPECT_EQ(darr[999][1], 999);
+    EXPECT_LE(n_reallocations, 11);
+
+    darr.resize(10, 3);
+    EXPECT_GE(darr.row_capacity(), 1000);
+    darr.shrink_to_fit();
+    EXPECT_EQ(darr.row_capacity(), 10);
+    EXPECT_EQ(darr[9][0], 9);
+
+    darr.reserve_rows(50);
+    EXPECT_EQ(darr.row_capacity(), 50);
+    EXPECT_EQ(darr.n_rows(), 10);
+
+    // the fill value may live inside the array being grown
+    darr.resize(200, 3, darr[3][1]);
+    EXPECT_EQ(darr[199][2], 3);
+
+    const DenseArray<int> copy = darr;
+    EXPECT_EQ(copy.row_capacity(), 200);
+    EXPECT_EQ(copy[199][0], 3);
+}
+
+// -----------------------------------------------------------------------------
+// ---------------------------------- Matrix -----------------------------------
+// -----------------------------------------------------------------------------
+
+static Matrix<double> pseudo_random_matrix(std::size_t size, unsigned seed = 1)
+{
+    Matrix<double> m(size);
+    for (std::size_t i = 0; i < size; i++) {
+        for (std::size_t j = 0; j < size; j++) {
+            seed = seed * 1103515245u + 12345u;
+            m[i][j] = double((seed >> 16) % 2001) / 1000.0 - 1.0;
+        }
+    }
+    return m;
+}
+
+TEST(Matrix, row_access)
+{
+    Matrix<double> m{{1, 2}, {3, 4}};
+    EXPECT_EQ(m.n_rows(), 2);
+    EXPECT_EQ(m.n_cols(), 2);
+    m[0][1] = 5;
+    EXPECT_DOUBLE_EQ(m.data()[0][1], 5);
+}
+
+TEST(Matrix, transpose)
+{
+    Matrix<double> m{{1, 2, 3}, {4, 5, 6}};
+    Matrix<double> t = m.transpose();
+    EXPECT_EQ(t.n_rows(), 3);
+    EXPECT_EQ(t.n_cols(), 2);
+    EXPECT_DOUBLE_EQ(t[2][0], 3);
+    EXPECT_DOUBLE_EQ(t[0][1], 4);
+}
+
+TEST(Matrix, transpose_large_non_square)
+{
+    Matrix<double> m(150, 70);
+    for (std::size_t i = 0; i < m.n_rows(); i++) {
+        for (std::size_t j = 0; j < m.n_cols(); j++) {
+            m[i][j] = double(i * 1000 + j);
+        }
+    }
+    Matrix<double> t = m.transpose();
+    ASSERT_EQ(t.n_rows(), 70);
+    ASSERT_EQ(t.n_cols(), 150);
+    for (std::size_t i = 0; i < m.n_rows(); i++) {
+        for (std::size_t j = 0; j < m.n_cols(); j++) {
+            EXPECT_DOUBLE_EQ(t[j][i], m[i][j]);
+        }
+    }
+}
+
+TEST(Matrix, transpose_inplace)
+{
+    for (std::size_t size : {1, 5, 33, 100}) {
+        Matrix<double> m = pseudo_random_matrix(size, 11);
+        Matrix<double> expected = m.transpose();
+        m.transpose_inplace();
+        for (std::size_t i = 0; i < size; i++) {
+            for (std::size_t j = 0; j < size; j++) {
+                EXPECT_DOUBLE_EQ(m[i][j], expected[i][j]);
+            }
+        }
+    }
+}
+
+TEST(Matrix, determinant)
+{
+    Matrix<double> m{{2, -1, 0}, {-1, 2, -1}, {0, -1, 2}};
+    EXPECT_NEAR(m.determinant(), 4.0, 1e-12);
+
+    Matrix<double> swapped{{0, 1}, {1, 0}};
+    EXPECT_NEAR(swapped.determinant(), -1.0, 1e-12);
+
+    Matrix<double> singular{{1, 2}, {2, 4}};
+    EXPECT_NEAR(singular.determinant(), 0.0, 1e-12);
+
+    EXPECT_NEAR(Matrix<double>::identity(10).determinant(), 1.0, 1e-12);
+}
+
+TEST(Matrix, lazy_expression)
+{
+    Matrix<double> a = pseudo_random_matrix(37, 5);
+    Matrix<double> b = pseudo_random_matrix(37, 6);
+
+    Matrix<double> res = a * 3.0 - b + a;
+    for (std::size_t i = 0; i < 37; i++) {
+        for (std::size_t j = 0; j < 37; j++) {
+            EXPECT_DOUBLE_EQ(res[i][j], a[i][j] * 3.0 - b[i][j] + a[i][j]);
+        }
+    }
+
+    res = res - a * 4.0;
+    EXPECT_DOUBLE_EQ(res[3][7], -b[3][7]);
+}
+
+// -----------------------------------------------------------------------------
+// --------------------------------- MatrixView --------------------------------
+// -----------------------------------------------------------------------------
+
+TEST(MatrixView, sub_views)
+{
+    Matrix<double> m{{1, 2, 3}, {4, 5, 6}, {7, 8, 9}};
+
+    ConstMatrixView<double> blk = std::as_const(m).block(1, 1, 2, 2);
+    EXPECT_EQ(blk.n_rows(), 2);
+    EXPECT_DOUBLE_EQ(blk(0, 0), 5);
+    EXPECT_DOUBLE_EQ(blk(1, 1), 9);
+    EXPECT_DOUBLE_EQ(blk.transposed()(0, 1), 8);
+    EXPECT_DOUBLE_EQ(m.col(2)(1, 0), 6);
+    EXPECT_DOUBLE_EQ(m.row(1)(0, 2), 6);
+
+    // writes go straight to the matrix
+    m.col(0).fill(0);
+    m.transposed_view()(2, 1) = -1;
+    EXPECT_DOUBLE_EQ(m[2][0], 0);
+    EXPECT_DOUBLE_EQ(m[1][2], -1);
+
+    Matrix<double> sum = m.block(0, 0, 2, 2) + m.block(1, 1, 2, 2) * 2.0;
+    EXPECT_DOUBLE_EQ(sum[0][1], 2 + 2 * -1.0);
+    EXPECT_DOUBLE_EQ(Matrix<double>(m.transposed_view())[0][1], 0);
+}
+
+TEST(MatrixView, algorithms_accept_views)
+{
+    const Matrix<double> a = pseudo_random_matrix(70, 21);
+    const Matrix<double> b = pseudo_random_matrix(70, 22);
+
+    // A^T * B on a 50 x 40 tile, with A^T read through a transposed view
+    Matrix<double> tile_product(50, 40);
+    gemm(1.0, a.transposed_view().block(0, 10, 50, 30), b.block(5, 20, 30, 40), 0.0, tile_product.view());
+    const Matrix<double> expected = Matrix<double>(a.transpose().block(0, 10, 50, 30)) * Matrix<double>(b.block(5, 20, 30, 40));
+    for (std::size_t i = 0; i < 50; i++) {
+        for (std::size_t j = 0; j < 40; j++) {
+            EXPECT_NEAR(tile_product[i][j], expected[i][j], 1e-12);
+        }
+    }
+
+    Matrix<double> t(30, 20);
+    transpose(a.block(3, 4, 20, 30), t.view());
+    EXPECT_DOUBLE_EQ(t[7][11], a[14][11]);
+
+    EXPECT_NEAR(determinant(a.block(10, 10, 30, 30)), Matrix<double>(a.block(10, 10, 30, 30)).determinant(), 1e-12);
+    EXPECT_NEAR(determinant(a.transposed_view()), a.determinant(), 1e-9 * std::fabs(a.determinant()));
+}
+
+// -----------------------------------------------------------------------------
+// -------------------------------- FixedMatrix --------------------------------
+// -----------------------------------------------------------------------------
+
+TEST(FixedMatrix, constexpr_operations)
+{
+    constexpr FixedMatrix<double, 2, 3> a{{1, 2, 3}, {4, 5, 6}};
+    constexpr FixedMatrix<double, 3, 2> t = a.transpose();
+    static_assert(t[2][0] == 3 && t[0][1] == 4);
+
+    constexpr FixedMatrix<double, 2, 2> product = a * t;
+    static_assert(product == FixedMatrix<double, 2, 2>{{14, 32}, {32, 77}});
+    static_assert(product.determinant() == 14 * 77 - 32 * 32);
+    static_assert(FixedMatrix<double, 5, 5>::identity().determinant() == 1);
+}
+
+TEST(FixedMatrix, determinant_matches_matrix)
+{
+    auto check = [](auto fixed) {
+        const Matrix<double> dynamic = fixed.to_matrix();
+        EXPECT_NEAR(fixed.determinant(), dynamic.determinant(), 1e-12);
+        EXPECT_EQ(decltype(fixed)(dynamic), fixed);
+    };
+
+    check(FixedMatrix<double, 1, 1>(pseudo_random_matrix(1, 3)));
+    check(FixedMatrix<double, 2, 2>(pseudo_random_matrix(2, 3)));
+    check(FixedMatrix<double, 3, 3>(pseudo_random_matrix(3, 3)));
+    check(FixedMatrix<double, 4, 4>(pseudo_random_matrix(4, 3)));
+    check(FixedMatrix<double, 6, 6>(pseudo_random_matrix(6, 3)));
+    check(FixedMatrix<double, 3, 3>{{0, 1, 0}, {1, 0, 0}, {0, 0, 1}});
+    check(FixedMatrix<double, 5, 5>{{1, 2, 3, 4, 5}, {2, 4, 6, 8, 10}, {0, 1, 0, 0, 0}, {0, 0, 1, 0, 0}, {0, 0, 0, 0, 1}});
+
+    // pivots far below epsilon are still regular, det(1e-20 * I) = 1e-100 and not 0
+    FixedMatrix<double, 5, 5> tiny;
+    FixedMatrix<double, 4, 4> tiny_closed_form;
+    for (std::size_t i = 0; i < 5; i++) {
+        tiny[i][i] = 1e-20;
+        if (i < 4) {
+            tiny_closed_form[i][i] = 1e-20;
+        }
+    }
+    EXPECT_NEAR(tiny.determinant() / 1e-100, 1.0, 1e-12);
+    EXPECT_NEAR(tiny.determinant() / tiny.to_matrix().determinant(), 1.0, 1e-12);
+    EXPECT_NEAR(tiny_closed_form.determinant() / 1e-80, 1.0, 1e-12);
+}
+
+// -----------------------------------------------------------------------------
+// ---------------------------------- kernels ----------------------------------
+// -----------------------------------------------------------------------------
+
+template <typename T>
+static void check_kernels_at_every_simd_level()
+{
+    const kernels::SimdLevel detected = kernels::detect_simd_level();
+    for (int level = 0; level <= int(detected); level++) {
+        kernels::set_simd_level(kernels::SimdLevel(level));
+
+        for (std::size_t n : {0, 1, 3, 8, 17, 64, 101}) {
+            std::vector<T> x(n), y(n);
+            for (std::size_t i = 0; i < n; i++) {
+                x[i] = T(i % 7) - T(3.5);
+                y[i] = T(i % 5) * T(0.25);
+            }
+
+            std::vector<T> expected = y;
+            for (std::size_t i = 0; i < n; i++) {
+                expected[i] += T(2) * x[i];
+                expected[i] -= x[i];
+                expected[i] += x[i];
+                expected[i] *= T(0.5);
+            }
+            kernels::axpy(n, T(2), x.data(), y.data());
+            kernels::sub(n, x.data(), y.data());
+            kernels::add(n, x.data(), y.data());
+            kernels::scale(n, T(0.5), y.data());
+            for (std::size_t i = 0; i < n; i++) {
+                EXPECT_NEAR(y[i], expected[i], 1e-5) << "level " << level << " n " << n;
+            }
+
+            if (n > 0) {
+                x[n / 2] = T(-100);
+                x[n - 1] = T(100);
+                EXPECT_EQ(kernels::iamax(n, x.data()), n == 1 ? 0 : n / 2) << "level " << level;
+            }
+        }
+    }
+    kernels::set_simd_level(detected);
+}
+
+TEST(Kernels, double_simd_levels)
+{
+    check_kernels_at_every_simd_level<double>();
+}
+
+TEST(Kernels, float_simd_levels)
+{
+    check_kernels_at_every_simd_level<float>();
+}
+
+TEST(Kernels, strided_iamax)
+{
+    double column[] = {1, 0, -5, 0, 5, 0, 2, 0};
+    EXPECT_EQ(kernels::iamax(4, column, 2), 1);
+}
+
+// -----------------------------------------------------------------------------
+// ----------------------------------- GEMM ------------------------------------
+// -----------------------------------------------------------------------------
+
+static Matrix<double> naive_product(const Matrix<double>& a, const Matrix<double>& b)
+{
+    Matrix<double> res(a.n_rows(), b.n_cols());
+    for (std::size_t i = 0; i < a.n_rows(); i++) {
+        for (std::size_t j = 0; j < b.n_cols(); j++) {
+            for (std::size_t k = 0; k < a.n_cols(); k++) {
+                res[i][j] += a[i][k] * b[k][j];
+            }
+        }
+    }
+    return res;
+}
+
+TEST(GEMM, operator_multiply)
+{
+    Matrix<double> a{{1, 2, 3}, {4, 5, 6}};
+    Matrix<double> b{{7, 8}, {9, 10}, {11, 12}};
+    Matrix<double> c = a * b;
+    EXPECT_EQ(c.n_rows(), 2);
+    EXPECT_EQ(c.n_cols(), 2);
+    EXPECT_DOUBLE_EQ(c[0][0], 58);
+    EXPECT_DOUBLE_EQ(c[0][1], 64);
+    EXPECT_DOUBLE_EQ(c[1][0], 139);
+    EXPECT_DOUBLE_EQ(c[1][1], 154);
+}
+
+TEST(GEMM, blocked_matches_naive_at_every_simd_level)
+{
+    Matrix<double> a(pseudo_random_matrix(301, 5));
+    Matrix<double> b(pseudo_random_matrix(301, 6));
+    a.resize(301, 280);
+    Matrix<double> expected = naive_product(a, b);
+
+    const kernels::SimdLevel detected = kernels::detect_simd_level();
+    for (int level = 0; level <= int(detected); level++) {
+        kernels::set_simd_level(kernels::SimdLevel(level));
+        Matrix<double> c(a.n_rows(), b.n_cols());
+        c.data().fill(1.0);
+        gemm(2.0, a, b, -1.0, c, 3);
+        for (std::size_t i = 0; i < c.n_rows(); i++) {
+            for (std::size_t j = 0; j < c.n_cols(); j++) {
+                ASSERT_NEAR(c[i][j], 2.0 * expected[i][j] - 1.0, 1e-10) << "level " << level;
+            }
+        }
+    }
+    kernels::set_simd_level(detected);
+}
+
+// -----------------------------------------------------------------------------
+// ------------------------------------ LU -------------------------------------
+// -----------------------------------------------------------------------------
+
+TEST(LU, reconstructs_matrix)
+{
+    Matrix<double> m = pseudo_random_matrix(37);
+    LU<double> lu = m.lu(8);
+
+    Matrix<double> permuted(m);
+    for (std::size_t i = 0; i < lu.size(); i++) {
+        permuted.swap_rows(i, lu.pivots()[i]);
+    }
+
+    for (std::size_t i = 0; i < lu.size(); i++) {
+        for (std::size_t j = 0; j < lu.size(); j++) {
+            double sum = 0;
+            for (std::size_t k = 0; k <= std::min(i, j); k++) {
+                double l = (k == i) ? 1.0 : lu.factors()[i][k];
+                sum += l * lu.factors()[k][j];
+            }
+            EXPECT_NEAR(sum, permuted[i][j], 1e-12);
+        }
+    }
+}
+
+TEST(LU, block_size_does_not_change_result)
+{
+    Matrix<double> m = pseudo_random_matrix(100, 7);
+    LU<double> unblocked = m.lu(1);
+    LU<double> blocked = m.lu(16);
+
+    for (std::size_t i = 0; i < m.n_rows(); i++) {
+        EXPECT_EQ(unblocked.pivots()[i], blocked.pivots()[i]);
+    }
+    EXPECT_NEAR(blocked.determinant() / unblocked.determinant(), 1.0, 1e-10);
+}
+
+TEST(LU, threads_keep_pivot_sequence)
+{
+    Matrix<double> m = pseudo_random_matrix(300, 3);
+    LU<double> serial = m.lu(32);
+    LU<double> parallel = m.lu(32, 4);
+
+    for (std::size_t i = 0; i < m.n_rows(); i++) {
+        EXPECT_EQ(serial.pivots()[i], parallel.pivots()[i]);
+    }
+    EXPECT_EQ(serial.determinant(), parallel.determinant());
+}
+
+TEST(LU, recursive_matches_blocked)
+{
+    for (std::size_t size : {1, 2, 37, 130}) {
+        Matrix<double> m = pseudo_random_matrix(size, 11);
+        LU<double> blocked = m.lu(8, 1, LUAlgorithm::Blocked);
+        LU<double> recursive = m.lu(8, 1, LUAlgorithm::Recursive);
+        LU<double> parallel = m.lu(8, 4, LUAlgorithm::Recursive);
+        EXPECT_EQ(recursive.algorithm(), LUAlgorithm::Recursive);
+
+        for (std::size_t i = 0; i < size; i++) {
+            EXPECT_EQ(blocked.pivots()[i], recursive.pivots()[i]);
+            for (std::size_t j = 0; j < size; j++) {
+                EXPECT_NEAR(blocked.factors()[i][j], recursive.factors()[i][j], 1e-9);
+            }
+        }
+        EXPECT_NEAR(recursive.determinant() / blocked.determinant(), 1.0, 1e-10);
+        EXPECT_EQ(recursive.determinant(), parallel.determinant());
+    }
+
+    Matrix<double> singular = pseudo_random_matrix(50, 5);
+    for (std::size_t i = 0; i < singular.n_rows(); i++) {
+        singular[i][40] = 0;
+    }
+    EXPECT_TRUE(singular.lu(4, 1, LUAlgorithm::Recursive).is_singular());
+
+    EXPECT_EQ(pseudo_random_matrix(10, 1).lu().algorithm(), LUAlgorithm::Blocked);
+}
+
+TEST(LU, task_graph_matches_blocked)
+{
+    for (std::size_t size : {5, 33, 130}) {
+        Matrix<double> m = pseudo_random_matrix(size, 13);
+        LU<double> blocked = m.lu(2, 1, LUAlgorithm::Blocked);
+        for (std::size_t n_threads : {1, 4}) {
+            LU<double> tiled = m.lu(2, n_threads, LUAlgorithm::TaskGraph);
+            for (std::size_t i = 0; i < size; i++) {
+                EXPECT_EQ(blocked.pivots()[i], tiled.pivots()[i]);
+                for (std::size_t j = 0; j < size; j++) {
+                    EXPECT_NEAR(blocked.factors()[i][j], tiled.factors()[i][j], 1e-9);
+                }
+            }
+            EXPECT_NEAR(tiled.determinant() / blocked.determinant(), 1.0, 1e-10);
+        }
+    }
+
+    Matrix<double> singular = pseudo_random_matrix(60, 5);
+    for (std::size_t i = 0; i < singular.n_rows(); i++) {
+        singular[i][45] = 0;
+    }
+    EXPECT_TRUE(singular.lu(2, 4, LUAlgorithm::TaskGraph).is_singular());
+}
+
+TEST(TaskScheduler, runs_spawned_tasks_once)
+{
+    ThreadPool pool(4);
+    TaskScheduler scheduler(pool.n_threads());
+    std::vector<std::atomic<int>> hits(1000);
+    std::function<void(std::size_t, std::size_t)> split = [&](std::size_t begin, std::size_t end) {
+        if (end - begin == 1) {
+            hits[begin]++;
+            return;
+        }
+        const std::size_t mid = begin + (end - begin) / 2;
+        scheduler.spawn([&, begin, mid] { split(begin, mid); }, begin == 0);
+        scheduler.spawn([&, mid, end] { split(mid, end); });
+    };
+    scheduler.spawn([&] { split(0, hits.size()); });
+    scheduler.run(&pool);
+
+    for (const std::atomic<int>& hit : hits) {
+        EXPECT_EQ(hit.load(), 1);
+    }
+}
+
+TEST(ThreadPool, parallel_for_covers_range)
+{
+    ThreadPool pool(4);
+    std::vector<int> hits(1000, 0);
+    pool.parallel_for(0, hits.size(), 7, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; i++) {
+            hits[i]++;
+        }
+    });
+    for (int hit : hits) {
+        EXPECT_EQ(hit, 1);
+    }
+}
+
+TEST(LU, solve)
+{
+    Matrix<double> m{{4, -2, 1}, {-2, 4, -2}, {1, -2, 4}};
+    LU<double> lu = m.lu();
+    Array<double> x = *lu.solve(Array<double>{11, -16, 17});
+    EXPECT_NEAR(x[0], 1, 1e-12);
+    EXPECT_NEAR(x[1], -2, 1e-12);
+    EXPECT_NEAR(x[2], 3, 1e-12);
+}
+
+TEST(LU, singular_solve_fails)
+{
+    // a zero column gives an exact zero pivot
+    const Matrix<double> m{{1, 0, 3}, {4, 0, 6}, {5, 0, 9}};
+    const LU<double> lu = m.lu();
+    ASSERT_TRUE(lu.is_singular());
+    EXPECT_FALSE(lu.solve(Array<double>{1, 2, 3}).has_value());
+    EXPECT_FALSE(solve(m, Array<double>{1, 2, 3}).has_value());
+
+    Matrix<double> b{{1, 2}, {3, 4}, {5, 6}};
+    EXPECT_FALSE(lu.solve_inplace(b.view()));
+    EXPECT_DOUBLE_EQ(b[0][0], 1);
+    EXPECT_DOUBLE_EQ(b[2][1], 6);
+    EXPECT_FALSE(solve(m, b).has_value());
+    EXPECT_FALSE(m.inverse().has_value());
+    EXPECT_FALSE(MixedPrecisionLU<double>(m.view()).solve(Array<double>{1, 2, 3}).has_value());
+}
+
+TEST(LU, solve_many_right_hand_sides)
+{
+    for (std::size_t size : {1, 7, 64, 150}) {
+        const Matrix<double> a = pseudo_random_matrix(size, 31) + Matrix<double>::identity(size) * 4.0;
+        const Matrix<double> x(pseudo_random_matrix(size, 32).block(0, 0, size, std::min<std::size_t>(size, 5)));
+        const Matrix<double> b = a * x;
+
+        const Matrix<double> solved = *solve(a, b);
+        for (std::size_t i = 0; i < size; i++) {
+            for (std::size_t j = 0; j < x.n_cols(); j++) {
+                EXPECT_NEAR(solved[i][j], x[i][j], 1e-10) << size;
+            }
+        }
+
+        const Matrix<double> product = a * *a.inverse();
+        for (std::size_t i = 0; i < size; i++) {
+            for (std::size_t j = 0; j < size; j++) {
+                EXPECT_NEAR(product[i][j], i == j ? 1.0 : 0.0, 1e-10) << size;
+            }
+        }
+    }
+}
+
+TEST(LU, scaled_determinant)
+{
+    // 1e200 * 1e200 * (1e-10)^40 overflows a plain running product after two steps
+    Matrix<double> m = Matrix<double>::diag(42, 1e-10);
+    m[0][0] = m[1][1] = 1e200;
+    m.swap_rows(0, 1);
+    EXPECT_NEAR(m.determinant(), -1.0, 1e-12);
+
+    // |det| = 1e600 does not fit into a double, its logarithm does
+    const Matrix<double> big = Matrix<double>::diag(600, 10.0) * -1.0;
+    EXPECT_TRUE(std::isinf(big.determinant()));
+    const LogDeterminant<double> log_det = big.log_abs_determinant();
+    EXPECT_DOUBLE_EQ(log_det.sign, 1);
+    EXPECT_NEAR(log_det.log_abs, 600 * std::log(10.0), 1e-9);
+
+    const LogDeterminant<double> singular = Matrix<double>{{1, 2}, {2, 4}}.log_abs_determinant();
+    EXPECT_EQ(singular.sign, 0);
+    EXPECT_TRUE(std::isinf(singular.log_abs));
+
+    // the sign survives an underflowing determinant
+    Matrix<double> tiny = Matrix<double>::diag(40, 0.1);
+    tiny.swap_rows(0, 1);
+    EXPECT_LT(tiny.determinant(), 0);
+    EXPECT_EQ(tiny.log_abs_determinant().sign, -1);
+}
+
+TEST(LU, small_entries_are_not_singular)
+{
+    const LogDeterminant<double> small = Matrix<double>::diag(10, 1e-20).log_abs_determinant();
+    EXPECT_EQ(small.sign, 1);
+    EXPECT_NEAR(small.log_abs, 10 * std::log(1e-20), 1e-9);
+
+    // pivots of 1e17 and -1e-17, det = 2 - 1
+    const Matrix<double> mixed_scale{{1, 1e-17}, {1e17, 2}};
+    EXPECT_FALSE(mixed_scale.lu().is_singular());
+    EXPECT_NEAR(mixed_scale.determinant(), 1.0, 1e-12);
+}
+
+TEST(LU, singular)
+{
+    Matrix<double> m{{1, 2, 3}, {2, 4, 6}, {1, 0, 1}};
+    EXPECT_TRUE(m.lu().is_singular());
+    EXPECT_DOUBLE_EQ(m.determinant(), 0);
+}
+
+// -----------------------------------------------------------------------------
+// ------------------------------ mixed precision ------------------------------
+// -----------------------------------------------------------------------------
+
+TEST(MixedPrecision, determinant)
+{
+    for (std::size_t size : {1, 3, 40, 200}) {
+        Matrix<double> m = pseudo_random_matrix(size, 41);
+        // rows far outside float's range must survive the conversion
+        for (std::size_t j = 0; j < size; j++) {
+            m[0][j] *= 1e100;
+        }
+        const LogDeterminant<double> expected = m.log_abs_determinant();
+        const LogDeterminant<double> mixed = MixedPrecisionLU<double>(m.view()).log_abs_determinant();
+        EXPECT_EQ(mixed.sign, expected.sign) << size;
+        EXPECT_NEAR(mixed.log_abs, expected.log_abs, 1e-4) << size;
+    }
+
+    // entries of 1e-30 are outside float's normal range, the row scaling keeps them
+    const Matrix<double> small = Matrix<double>{{4, 1}, {2, 3}} * 1e-30;
+    EXPECT_FALSE(MixedPrecisionLU<double>(small.view()).needs_high_precision());
+    EXPECT_NEAR(mixed_precision_determinant(small) / 1e-59, 1.0, 1e-6);
+
+    const Matrix<double> singular{{1, 2}, {2, 4}};
+    EXPECT_TRUE(MixedPrecisionLU<double>(singular.view()).needs_high_precision());
+    EXPECT_DOUBLE_EQ(mixed_precision_determinant(singular), 0);
+
+    // regular in float, but 1 + 1e-6 rounds to 1 + 9.5e-7 and float pivots give det 5% off
+    const Matrix<double> nearly_singular{{1, 1}, {1, 1 + 1e-6}};
+    EXPECT_TRUE(MixedPrecisionLU<double>(nearly_singular.view()).needs_high_precision());
+    EXPECT_NEAR(mixed_precision_determinant(nearly_singular) / 1e-6, 1.0, 1e-9);
+
+    // cond(hilbert(8)) ~ 1e10, float factors keep no correct digit of det ~ 2.7e-33
+    Matrix<double> hilbert(8);
+    for (std::size_t i = 0; i < 8; i++) {
+        for (std::size_t j = 0; j < 8; j++) {
+            hilbert[i][j] = 1.0 / double(i + j + 1);
+        }
+    }
+    EXPECT_TRUE(MixedPrecisionLU<double>(hilbert.view()).needs_high_precision());
+    EXPECT_NEAR(mixed_precision_determinant(hilbert) / hilbert.determinant(), 1.0, 1e-12);
+}
+
+TEST(MixedPrecision, refined_solve)
+{
+    const std::size_t size = 150;
+    const Matrix<double> a = pseudo_random_matrix(size, 43) + Matrix<double>::identity(size) * 4.0;
+    Array<double> x(size);
+    for (std::size_t i = 0; i < size; i++) {
+        x[i] = std::sin(double(i));
+    }
+    Array<double> rhs(size, 0.0);
+    for (std::size_t i = 0; i < size; i++) {
+        for (std::size_t j = 0; j < size; j++) {
+            rhs[i] += a[i][j] * x[j];
+        }
+    }
+
+    // float factors alone give ~1e-6, refinement reaches double accuracy
+    const Array<double> solved = *MixedPrecisionLU<double>(a.view()).solve(rhs);
+    for (std::size_t i = 0; i < size; i++) {
+        EXPECT_NEAR(solved[i], x[i], 1e-12);
+    }
+
+    // cond(hilbert(10)) ~ 1e13, beyond what float factors can refine, the solve falls back to double
+    Matrix<double> hilbert(10);
+    for (std::size_t i = 0; i < 10; i++) {
+        for (std::size_t j = 0; j < 10; j++) {
+            hilbert[i][j] = 1.0 / double(i + j + 1);
+        }
+    }
+    const Array<double> ones(10, 1.0);
+    const Array<double> expected = *hilbert.lu().solve(ones);
+    const Array<double> fallback = *MixedPrecisionLU<double>(hilbert.view()).solve(ones);
+    for (std::size_t i = 0; i < 10; i++) {
+        EXPECT_NEAR(fallback[i] / expected[i], 1.0, 1e-6);
+    }
+}
+
+// -----------------------------------------------------------------------------
+// ----------------------------- exact determinant -----------------------------
+// -----------------------------------------------------------------------------
+
+// integers in [-range, range]
+static Matrix<long long> pseudo_random_integer_matrix(std::size_t size, long long range, unsigned seed)
+{
+    Matrix<long long> m(size);
+    for (std::size_t i = 0; i < size; i++) {
+        for (std::size_t j = 0; j < size; j++) {
+            seed = seed * 1103515245u + 12345u;
+            m[i][j] = static_cast<long long>((seed >> 16) % (2 * range + 1)) - range;
+        }
+    }
+    return m;
+}
+
+// the smallest user-defined ring, it only has the operations Bareiss elimination needs
+struct Integer {
+    long long value = 0;
+
+    Integer() = default;
+    Integer(long long val) : value(val) {}
+
+    Integer operator+(const Integer& other) const { return value + other.value; }
+    Integer operator-(const Integer& other) const { return value - other.value; }
+    Integer operator*(const Integer& other) const { return value * other.value; }
+    Integer operator/(const Integer& other) const { return value / other.value; }
+    Integer operator-() const { return -value; }
+    Integer& operator+=(const Integer& other) { value += other.value; return *this; }
+    Integer& operator-=(const Integer& other) { value -= other.value; return *this; }
+    Integer& operator*=(const Integer& other) { value *= other.value; return *this; }
+    bool operator==(const Integer&) const = default;
+};
+
+TEST(ExactDeterminant, integer_matrices)
+{
+    EXPECT_EQ((Matrix<int>{{2, 0, 1}, {1, 3, 2}, {1, 1, 2}}.determinant()), 6);
+    EXPECT_EQ((Matrix<long long>{{0, 1}, {1, 0}}.determinant()), -1);
+    EXPECT_EQ((Matrix<long long>{{1, 2, 3}, {2, 4, 6}, {7, 1, 5}}.determinant()), 0);
+
+    // far beyond the 2^53 integers a double holds exactly
+    const Matrix<long long> large{{-3000000000, 7}, {5, 3000000000}};
+    EXPECT_EQ(large.determinant(), -9000000000000000035);
+    EXPECT_EQ(bareiss_determinant(large.data()), -9000000000000000035);
+
+    const Matrix<Integer> user_ring{{2, 0, 1}, {1, 3, 2}, {1, 1, 2}};
+    EXPECT_EQ(user_ring.determinant(), Integer(6));
+    const Matrix<Integer> square = user_ring * user_ring;
+    EXPECT_EQ(square[1][2], Integer(11));
+    EXPECT_EQ(square.determinant(), Integer(36));
+
+    // narrower than the 31-bit primes of the modular method
+    EXPECT_EQ((Matrix<short>{{2, 0}, {0, 3}}.determinant()), 6);
+    EXPECT_EQ((Matrix<std::int8_t>{{2, 1}, {-1, 3}}.determinant()), 7);
+}
+
+TEST(ExactDeterminant, modular_matches_bareiss)
+{
+    for (std::size_t size : {1, 2, 5, 12}) {
+        const Matrix<long long> m = pseudo_random_integer_matrix(size, 9, unsigned(size));
+        EXPECT_EQ(m.determinant(), bareiss_determinant(m.data())) << size;
+        EXPECT_EQ(modular_determinant<long long>(m.view(), 4), bareiss_determinant(m.data())) << size;
+    }
+
+    // |det| ~ 1e34 does not fit into long long, the result goes into a wider type
+    const Matrix<long long> big = pseudo_random_integer_matrix(16, 99, 7);
+    const long double det = static_cast<long double>(modular_determinant<__int128>(big.view(), 2));
+    Matrix<double> as_double(16);
+    for (std::size_t i = 0; i < 16; i++) {
+        for (std::size_t j = 0; j < 16; j++) {
+            as_double[i][j] = double(big[i][j]);
+        }
+    }
+    const double expected = as_double.determinant();
+    EXPECT_NEAR(double(det) / expected, 1.0, 1e-9);
+}
+
+// -----------------------------------------------------------------------------
+// ---------------------------- batched determinant ----------------------------
+// -----------------------------------------------------------------------------
+
+TEST(BatchedDeterminant, matches_matrix_determinant)
+{
+    for (std::size_t size : {1, 2, 3, 5, 16}) {
+        const std::size_t count = 37;
+        std::vector<double> contiguous(count * size * size);
+        std::vector<double> interleaved(contiguous.size());
+        std::vector<double> expected(count);
+
+        for (std::size_t b = 0; b < count; b++) {
+            Matrix<double> m = pseudo_random_matrix(size, unsigned(b + 1));
+            if (b == 4 && size > 1) {
+                m[1] = m[0];
+            }
+            // regular, only its pivots are far below epsilon
+            if (b == 7) {
+                m = Matrix<double>::diag(size, 1e-20);
+            }
+            expected[b] = m.determinant();
+            for (std::size_t i = 0; i < size; i++) {
+                for (std::size_t j = 0; j < size; j++) {
+                    contiguous[b * size * size + i * size + j] = m[i][j];
+                    interleaved[(i * size + j) * count + b] = m[i][j];
+                }
+            }
+        }
+
+        std::vector<double> from_contiguous(count), from_interleaved(count);
+        batched_determinant(size, count, contiguous.data(), from_contiguous.data());
+        batched_determinant(size, count, interleaved.data(), from_interleaved.data(), BatchLayout::Interleaved, 3);
+
+        for (std::size_t b = 0; b < count; b++) {
+            EXPECT_NEAR(from_contiguous[b], expected[b], 1e-9 * std::max(1.0, std::fabs(expected[b]))) << size << " " << b;
+            EXPECT_NEAR(from_interleaved[b], expected[b], 1e-9 * std::max(1.0, std::fabs(expected[b]))) << size << " " << b;
+        }
+        if (size < 16) {
+            EXPECT_NEAR(from_contiguous[7] / std::pow(1e-20, double(size)), 1.0, 1e-12) << size;
+        }
+    }
+}
+
+TEST(BatchedDeterminant, extreme_scale)
+{
+    // the top rows are scaled by 1e60 and the bottom ones by 1e-60: det stays near det(m), but the
+    // product of the first 8 pivots alone is ~1e480
+    const std::size_t size = 16;
+    const std::size_t count = 9;
+    std::vector<double> matrices(count * size * size);
+    std::vector<double> expected(count);
+    for (std::size_t b = 0; b < count; b++) {
+        Matrix<double> m = pseudo_random_matrix(size, unsigned(b + 100));
+        for (std::size_t i = 0; i < size; i++) {
+            for (std::size_t j = 0; j < size; j++) {
+                m[i][j] *= i < size / 2 ? 1e60 : 1e-60;
+                matrices[b * size * size + i * size + j] = m[i][j];
+            }
+        }
+        expected[b] = m.determinant();
+        ASSERT_TRUE(std::isfinite(expected[b]) && expected[b] != 0);
+    }
+
+    std::vector<double> determinants(count);
+    batched_determinant(size, count, matrices.data(), determinants.data());
+    for (std::size_t b = 0; b < count; b++) {
+        EXPECT_NEAR(determinants[b] / expected[b], 1.0, 1e-9) << b;
+    }
+}
+
+// -----------------------------------------------------------------------------
+// -------------------------------- SparseMatrix -------------------------------
+// -----------------------------------------------------------------------------
+
+// about density * size^2 off-diagonal non-zeros plus a diagonal that is sometimes zero
+static SparseMatrix<double> pseudo_random_sparse(std::size_t size, double density, unsigned seed)
+{
+    std::vector<SparseEntry<double>> entries;
+    auto next = [&seed] {
+        seed = seed * 1103515245u + 12345u;
+        return double((seed >> 16) % 2001) / 1000.0 - 1.0;
+    };
+    for (std::size_t i = 0; i < size; i++) {
+        if (next() > -0.8) {
+            entries.push_back({i, i, next() + 2.0});
+        }
+        for (std::size_t j = 0; j < size; j++) {
+            if ((next() + 1.0) / 2.0 < density) {
+                entries.push_back({i, j, next()});
+            }
+        }
+    }
+    return SparseMatrix<double>::from_entries(size, size, std::move(entries));
+}
+
+TEST(SparseMatrix, storage_and_conversions)
+{
+    const auto csr = SparseMatrix<double>::from_entries(3, 4, {{2, 1, 5}, {0, 3, 1}, {0, 3, 2}, {1, 0, 1}, {1, 0, -1}});
+    EXPECT_EQ(csr.nnz(), 2u);
+    EXPECT_EQ(csr.offsets(), (std::vector<std::size_t>{0, 1, 1, 2}));
+    EXPECT_DOUBLE_EQ(csr.at(0, 3), 3);
+    EXPECT_DOUBLE_EQ(csr.at(2, 1), 5);
+    EXPECT_DOUBLE_EQ(csr.at(1, 0), 0);
+
+    const SparseMatrix<double, SparseFormat::Csc> csc = csr.to_csc();
+    EXPECT_EQ(csc.offsets(), (std::vector<std::size_t>{0, 0, 1, 1, 2}));
+    EXPECT_EQ(csc.indices(), (std::vector<std::size_t>{2, 0}));
+    EXPECT_DOUBLE_EQ(csc.at(0, 3), 3);
+
+    const Matrix<double> dense = csc.to_matrix();
+    EXPECT_EQ(dense.n_rows(), 3u);
+    EXPECT_EQ(dense.n_cols(), 4u);
+    EXPECT_DOUBLE_EQ(dense[0][3], 3);
+    EXPECT_DOUBLE_EQ(dense[2][1], 5);
+
+    const SparseMatrix<double> round_trip(dense);
+    EXPECT_EQ(round_trip.indices(), csr.indices());
+    EXPECT_EQ(round_trip.values(), csr.values());
+
+    // tiny values are entries like any other, only exact zeros are dropped
+    const SparseMatrix<double> tiny(Matrix<double>{{1e-20, 0}, {0, 1e-30}});
+    EXPECT_EQ(tiny.nnz(), 2u);
+    EXPECT_DOUBLE_EQ(determinant(tiny), 1e-50);
+}
+
+TEST(SparseMatrix, text_readers)
+{
+    std::istringstream dense_text("3\n0 2 0\n0 0 0\n1 0 -4\n");
+    MatrixReader dense_reader(dense_text);
+    SparseMatrix<double> from_dense;
+    ASSERT_TRUE(read_sparse_text(dense_reader, from_dense));
+    EXPECT_EQ(from_dense.nnz(), 3u);
+    EXPECT_EQ(from_dense.offsets(), (std::vector<std::size_t>{0, 1, 1, 3}));
+    EXPECT_DOUBLE_EQ(from_dense.at(2, 2), -4);
+
+    std::istringstream tiny_text("2\n1e-20 0\n0 3\n");
+    MatrixReader tiny_reader(tiny_text);
+    SparseMatrix<double> tiny;
+    ASSERT_TRUE(read_sparse_text(tiny_reader, tiny));
+    EXPECT_DOUBLE_EQ(tiny.at(0, 0), 1e-20);
+
+    std::istringstream coordinate_text("3 3\n2 2 -4\n0 1 2\n2 0 1\n");
+    MatrixReader coordinate_reader(coordinate_text);
+    SparseMatrix<double> from_coordinates;
+    ASSERT_TRUE(read_coordinate_text(coordinate_reader, from_coordinates));
+    EXPECT_EQ(from_coordinates.indices(), from_dense.indices());
+    EXPECT_EQ(from_coordinates.values(), from_dense.values());
+
+    std::istringstream out_of_range("2 1\n0 2 1\n");
+    MatrixReader bad_reader(out_of_range);
+    EXPECT_FALSE(read_coordinate_text(bad_reader, from_coordinates));
+
+    // more entries than a 2 x 2 matrix has, and a count that must not be allocated up front
+    std::istringstream too_many("2 5\n0 0 1\n0 1 1\n1 0 1\n1 1 1\n0 0 1\n");
+    MatrixReader too_many_reader(too_many);
+    EXPECT_FALSE(read_coordinate_text(too_many_reader, from_coordinates));
+
+    std::istringstream huge_count("4000000000 1000000000000\n0 0 1\n");
+    MatrixReader huge_count_reader(huge_count);
+    EXPECT_FALSE(read_coordinate_text(huge_count_reader, from_coordinates));
+}
+
+TEST(SparseLU, determinant_matches_dense)
+{
+    for (std::size_t size : {1, 2, 10, 80, 200}) {
+        const SparseMatrix<double> sparse = pseudo_random_sparse(size, 0.03, unsigned(size));
+        const double expected = sparse.to_matrix().determinant();
+        EXPECT_NEAR(determinant(sparse), expected, 1e-9 * std::max(1.0, std::fabs(expected))) << size;
+
+        // strict partial pivoting picks other pivots but must agree
+        const SparseLU<double> strict(sparse.to_csc(), 1.0);
+        EXPECT_NEAR(strict.determinant(), expected, 1e-9 * std::max(1.0, std::fabs(expected))) << size;
+    }
+
+    EXPECT_DOUBLE_EQ(determinant(SparseMatrix<double>(Matrix<double>{{1, 2, 3}, {2, 4, 6}, {0, 0, 1}})), 0);
+    EXPECT_DOUBLE_EQ(determinant(SparseMatrix<double>(4, 4)), 0);
+}
+
+TEST(SparseLU, ordering_avoids_fill)
+{
+    // arrowhead: dense first row and column, eliminating vertex 0 first would fill the whole matrix
+    const std::size_t size = 100;
+    std::vector<SparseEntry<double>> entries;
+    for (std::size_t i = 0; i < size; i++) {
+        entries.push_back({i, i, 4.0});
+        if (i > 0) {
+            entries.push_back({0, i, 1.0});
+            entries.push_back({i, 0, 1.0});
+        }
+    }
+    const auto arrow = SparseMatrix<double, SparseFormat::Csc>::from_entries(size, size, std::move(entries));
+
+    const SparseLU<double> lu(arrow);
+    const auto& order = lu.column_order();
+    EXPECT_GE(std::find(order.begin(), order.end(), 0u) - order.begin(), std::ptrdiff_t(size - 2));
+    EXPECT_LE(lu.lower().nnz() + lu.upper().nnz(), arrow.nnz() + size);
+    EXPECT_NEAR(lu.determinant() / std::pow(4.0, size - 2), 4.0 * 4.0 - (size - 1), 1e-9);
+
+    const LogDeterminant<double> log_det = lu.log_abs_determinant();
+    EXPECT_DOUBLE_EQ(log_det.sign, -1);
+    EXPECT_NEAR(log_det.log_abs, (size - 2) * std::log(4.0) + std::log(double(size - 1 - 16)), 1e-9);
+}
+
+// -----------------------------------------------------------------------------
+// --------------------------------- Allocators --------------------------------
+// -----------------------------------------------------------------------------
+
+TEST(Allocators, aligned_allocator)
+{
+    Array<double, AlignedAllocator<double>> arr(5, 1.5);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(arr.begin()) % 64, 0);
+    EXPECT_DOUBLE_EQ(arr[4], 1.5);
+
+    Array<float> uninit(7, kUninitialized);
+    EXPECT_EQ(uninit.size(), 7);
+
+    DenseArray<double> darr(3, 5, kUninitialized);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(darr.row_begin(2)) % 64, 0);
+    // padding is still zeroed so that whole rows can be written out
+    EXPECT_DOUBLE_EQ(darr.row_begin(1)[darr.leading_dim() - 1], 0);
+}
+
+TEST(Allocators, arena_scratch_matrices)
+{
+    using ArenaMatrix = Matrix<double, ArenaAllocator<double>>;
+
+    Arena arena(1024);
+    const Matrix<double> reference = pseudo_random_matrix(40, 9);
+    for (int iter = 0; iter < 3; iter++) {
+        arena.reset();
+        ArenaMatrix scratch(40, 40, ArenaAllocator<double>(arena));
+        for (std::size_t i = 0; i < 40; i++) {
+            std::copy(reference[i].begin(), reference[i].end(), scratch[i].begin());
+        }
+
+        EXPECT_NEAR(scratch.determinant(), reference.determinant(), 1e-9);
+        EXPECT_EQ(scratch.lu().factors().get_allocator(), ArenaAllocator<double>(arena));
+        EXPECT_GT(arena.bytes_used(), 0);
+        // after the first reset everything fits into a single merged block
+        if (iter > 0) {
+            EXPECT_EQ(arena.n_blocks(), 1);
+        }
+    }
+}
+
+TEST(Allocators, arena_rectangular_array)
+{
+    Arena arena;
+    RectangularArray<int, ArenaAllocator<int>> rarr(2, 3, 7, ArenaAllocator<int>(arena));
+    rarr.resize(4, 1);
+    rarr.resize_rows(5, 2);
+
+    EXPECT_EQ(rarr.n_rows(), 4);
+    EXPECT_EQ(rarr.n_cols(), 5);
+    EXPECT_EQ(rarr[0][2], 7);
+    EXPECT_EQ(rarr[3][0], 1);
+    EXPECT_EQ(rarr[3][4], 2);
+    EXPECT_EQ(rarr[3].get_allocator().arena(), &arena);
+}
+
+// -----------------------------------------------------------------------------
+// ------------------------------------ Stats ----------------------------------
+// -----------------------------------------------------------------------------
+
+TEST(Stats, counts_determinant_work)
+{
+    ASSERT_TRUE(stats::kEnabled);
+    const Matrix<double> matrix = {{1, 2, 3}, {4, 5, 6}, {7, 8, 10}};
+
+    stats::reset();
+    EXPECT_NEAR(matrix.determinant(), -3.0, 1e-9);
+    const stats::Stats result = stats::snapshot();
+
+    // one panel: 2 rows * (2 * 2 + 1) flops for the first column, 1 * (2 * 1 + 1) for the second
+    EXPECT_EQ(result.pivot_searches, 3u);
+    EXPECT_EQ(result.row_swaps, 2u);
+    EXPECT_EQ(result.flops, 13u);
+    EXPECT_GE(result.allocations, 2u);
+    EXPECT_GE(result.allocated_bytes, 9 * sizeof(double));
+
+    stats::reset();
+    EXPECT_EQ(stats::snapshot().allocations, 0u);
+    {
+        stats::ScopedTimer timer(stats::Phase::Parse);
+        Array<double> array(100, 1.0);
+    }
+    EXPECT_EQ(stats::snapshot().allocations, 1u);
+    EXPECT_EQ(stats::snapshot().allocated_bytes, 100 * sizeof(double));
+    EXPECT_GT(stats::snapshot().parse_seconds, 0.0);
+}
+
+// -----------------------------------------------------------------------------
+// -------------------------------- MatrixReader -------------------------------
+// -----------------------------------------------------------------------------
+
+TEST(MatrixReader, reads_values_across_chunks)
+{
+    std::istringstream input("3\n1.5 -2 +3e2\n   4\t5 6.25\n7 8 9");
+    MatrixReader reader(input, 4);
+
+    std::size_t size = 0;
+    ASSERT_TRUE(reader.scan_until_next_line(size));
+    EXPECT_EQ(size, 3);
+
+    std::vector<double> values(9);
+    EXPECT_EQ(reader.read_values(values.data(), values.size()), 9);
+    EXPECT_DOUBLE_EQ(values[0], 1.5);
+    EXPECT_DOUBLE_EQ(values[1], -2);
+    EXPECT_DOUBLE_EQ(values[2], 300);
+    EXPECT_DOUBLE_EQ(values[5], 6.25);
+    EXPECT_DOUBLE_EQ(values[8], 9);
+
+    double extra = 0;
+    EXPECT_FALSE(reader.scan_until_next_line(extra));
+}
+
+TEST(MatrixReader, skips_rest_of_line_after_bad_token)
+{
+    std::istringstream input("1 2x 3\n# comment line\n4 5\n");
+    MatrixReader reader(input, 3);
+
+    double val = 0;
+    ASSERT_TRUE(reader.scan_until_next_line(val));
+    EXPECT_DOUBLE_EQ(val, 1);
+    ASSERT_TRUE(reader.scan_until_next_line(val));
+    EXPECT_DOUBLE_EQ(val, 4);
+    ASSERT_TRUE(reader.scan_until_next_line(val));
+    EXPECT_DOUBLE_EQ(val, 5);
+    EXPECT_FALSE(reader.scan_until_next_line(val));
+}
+
+// -----------------------------------------------------------------------------
+// ------------------------------- binary format -------------------------------
+// -----------------------------------------------------------------------------
+
+TEST(BinaryFormat, write_and_map)
+{
+    const std::string path = testing::TempDir() + "matrix_binary_format.mtxb";
+    Matrix<double> m{{1, 2, 3}, {4, 5, 6}};
+    ASSERT_TRUE(write_binary(m, path));
+    EXPECT_TRUE(is_binary_matrix_file(path));
+
+    MappedMatrix<double> mapped;
+    ASSERT_TRUE(mapped.map(path));
+    EXPECT_EQ(mapped.n_rows(), 2);
+    EXPECT_EQ(mapped.n_cols(), 3);
+    EXPECT_EQ(mapped.leading_dim(), m.data().leading_dim());
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(mapped.data()) % DenseArray<double>::kAlignment, 0);
+    EXPECT_DOUBLE_EQ(mapped[1][2], 6);
+
+    Matrix<double> copy = mapped.to_matrix();
+    EXPECT_DOUBLE_EQ(copy[0][1], 2);
+
+    MappedMatrix<float> wrong_type;
+    EXPECT_FALSE(wrong_type.map(path));
+
+    std::remove(path.c_str());
+}
+
+TEST(BinaryFormat, rejects_overflowing_header)
+{
+    const std::string path = testing::TempDir() + "matrix_binary_overflow.mtxb";
+    ASSERT_TRUE(write_binary(Matrix<double>{{1, 2}, {3, 4}}, path));
+
+    // n_rows * leading_dim * sizeof(double) wraps around to 0
+    BinaryHeader header;
+    std::ifstream(path, std::ios::binary).read(reinterpret_cast<char*>(&header), sizeof(header));
+    header.n_rows = std::uint64_t(1) << 61;
+    header.leading_dim = 8;
+    std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.close();
+
+    MappedMatrix<double> mapped;
+    EXPECT_FALSE(mapped.map(path));
+
+    // empty rows take no space, but n_rows of them would still be looped over
+    header.n_rows = std::uint64_t(1) << 40;
+    header.n_cols = 0;
+    header.leading_dim = 0;
+    file.open(path, std::ios::binary | std::ios::in | std::ios::out);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.close();
+    EXPECT_FALSE(mapped.map(path));
+
+    // a leading dimension shorter than a row
+    header.n_rows = 2;
+    header.n_cols = 2;
+    header.leading_dim = 1;
+    file.open(path, std::ios::binary | std::ios::in | std::ios::out);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.close();
+    EXPECT_FALSE(mapped.map(path));
+
+    std::remove(path.c_str());
+}
+
+TEST(BinaryFormat, rejects_text_file)
+{
+    const std::string path = testing::TempDir() + "matrix_text_format.txt";
+    std::ofstream(path) << "2\n1 2\n3 4\n";
+    EXPECT_FALSE(is_binary_matrix_file(path));
+
+    MappedMatrix<double> mapped;
+    EXPECT_FALSE(mapped.map(path));
+
+    std::remove(path.c_str());
+}
+
+// -----------------------------------------------------------------------------
+// --------------------------------- out-of-core -------------------------------
+// -----------------------------------------------------------------------------
+
+TEST(OutOfCoreLU, matches_in_memory)
+{
+    const std::string path = testing::TempDir() + "matrix_out_of_core.mtxb";
+    const std::size_t size = 70;
+    Matrix<double> m = pseudo_random_matrix(size, 17);
+    ASSERT_TRUE(write_binary(m, path));
+    MappedMatrix<double> mapped;
+    ASSERT_TRUE(mapped.map(path));
+    LU<double> in_memory = m.lu();
+
+    // one column, a width that does not divide the size, everything in one panel
+    for (std::size_t width : {std::size_t(1), std::size_t(3), std::size_t(16), size}) {
+        OutOfCoreLU<double> lu(OutOfCoreLU<double>::kBuffers * size * sizeof(double) * width, testing::TempDir());
+        ASSERT_TRUE(lu.factorize(mapped));
+        EXPECT_EQ(lu.panel_width(), width);
+        for (std::size_t i = 0; i < size; i++) {
+            EXPECT_EQ(lu.pivots()[i], in_memory.pivots()[i]);
+        }
+        EXPECT_NEAR(lu.determinant() / in_memory.determinant(), 1.0, 1e-10);
+        EXPECT_EQ(lu.log_abs_determinant().sign, in_memory.log_abs_determinant().sign);
+    }
+
+    OutOfCoreLU<double> too_small(OutOfCoreLU<double>::kBuffers * size * sizeof(double) - 1, testing::TempDir());
+    EXPECT_FALSE(too_small.factorize(mapped));
+
+    for (std::size_t i = 0; i < size; i++) {
+        m[i][33] = 0;
+    }
+    ASSERT_TRUE(write_binary(m, path));
+    ASSERT_TRUE(mapped.map(path));
+    OutOfCoreLU<double> singular(OutOfCoreLU<double>::kBuffers * size * sizeof(double) * 8, testing::TempDir(), 4);
+    ASSERT_TRUE(singular.factorize(mapped));
+    EXPECT_TRUE(singular.is_singular());
+    EXPECT_EQ(singular.determinant(), 0.0);
+
+    std::remove(path.c_str());
+}
+
 // -----------------------------------------------------------------------------
 // --------------------------- Edge cases and errors ---------------------------
 // -----------------------------------------------------------------------------